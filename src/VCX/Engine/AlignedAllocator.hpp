@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace VCX::Engine {
+    /** Allocator for large texel buffers:
+     *  - storage is 64-byte aligned (one cache line), or 2 MiB aligned from HugePageThreshold bytes on;
+     *  - elements constructed without arguments are default-initialized, so `resize(n)` of a trivial type
+     *    leaves memory untouched instead of zeroing it;
+     *  - with `hugePages`, large blocks are advised to the kernel as transparent huge pages (Linux only). */
+    template<typename T>
+    class AlignedAllocator {
+    public:
+        using value_type = T;
+        // the huge-page choice travels with the buffer
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap            = std::true_type;
+
+        static constexpr std::size_t CacheLine          = 64;
+        static constexpr std::size_t HugePage           = std::size_t(2) << 20;
+        static constexpr std::size_t HugePageThreshold  = std::size_t(8) << 20;
+
+        AlignedAllocator() = default;
+        explicit AlignedAllocator(bool const hugePages): _hugePages(hugePages) { }
+
+        template<typename U>
+        AlignedAllocator(AlignedAllocator<U> const & o): _hugePages(o.UsesHugePages()) { }
+
+        bool UsesHugePages() const { return _hugePages; }
+
+        T * allocate(std::size_t const n) {
+            std::size_t const bytes = n * sizeof(T);
+            void *            p     = ::operator new(bytes, std::align_val_t(AlignmentFor(bytes)));
+#ifdef MADV_HUGEPAGE
+            if (_hugePages && bytes >= HugePageThreshold) madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+            return static_cast<T *>(p);
+        }
+
+        void deallocate(T * const p, std::size_t const n) {
+            ::operator delete(p, std::align_val_t(AlignmentFor(n * sizeof(T))));
+        }
+
+        template<typename U>
+        void construct(U * const p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+            ::new (static_cast<void *>(p)) U;
+        }
+
+        template<typename U, typename... Args>
+        void construct(U * const p, Args &&... args) {
+            ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        // the alignment depends on the block size only, so any two instances can free each other's memory
+        template<typename U>
+        bool operator==(AlignedAllocator<U> const &) const { return true; }
+
+    private:
+        bool _hugePages = false;
+
+        static constexpr std::size_t AlignmentFor(std::size_t const bytes) {
+            return bytes >= HugePageThreshold ? HugePage : CacheLine;
+        }
+    };
+} // namespace VCX::Engine
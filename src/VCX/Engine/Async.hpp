@@ -1,67 +1,194 @@
 #pragma once
 
 #include <any>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Engine/Executor.hpp"
 
 namespace VCX::Engine {
-    // an computationally expensive value that will be asynchronously evaluated.
+    // an computationally expensive value that will be asynchronously evaluated on the shared Executor.
     // the method names are intendedly aligned with std::optional<T>;
+    // a new evaluation cancels the one it replaces without waiting for it, only destruction waits.
     template<typename T>
     class Async {
     public:
+        using Priority = Executor::Priority;
+
         Async() = default;
-        Async(std::function<T()> && func) { Emplace(func); }
+        Async(std::function<T()> && func) { Emplace(std::move(func)); }
+        Async(Async &&) = default;
+
+        Async & operator=(Async && o) {
+            if (this != &o) {
+                Drain();
+                _state      = std::move(o._state);
+                _superseded = std::move(o._superseded);
+            }
+            return *this;
+        }
 
-        ~Async() { if (_thread.joinable()) _thread.join(); }
+        ~Async() { Drain(); }
 
         void Reset() {
-          if (_thread.joinable()) _thread.join();
-          _completed = false;
+            Supersede();
         }
 
-        void Emplace(std::function<T()> && func) {
-            if (_thread.joinable()) _thread.join();
-            _completed = false;
-            _thread = std::move(std::thread([
-                func        = std::move(func),
-                & completed = _completed,
-                & result    = _result]() {
-                result = func();
-                completed.store(true);
-            }));
+        void Emplace(std::function<T()> && func, Priority const priority = Priority::Normal) {
+            Emplace([func = std::move(func)](CancellationToken const &) { return func(); }, priority);
         }
 
-        bool HasValue() const { return _completed.load(); }
+        // `func` should poll the token and return early once it is cancelled; whatever it returns then is discarded
+        void Emplace(std::function<T(CancellationToken const &)> && func, Priority const priority = Priority::Normal) {
+            Supersede();
+            auto state = std::make_shared<State>();
+            _state     = state;
+            Executor::Instance().Submit([state, func = std::move(func)]() {
+                if (! state->cancel.IsCancelled()) {
+                    try {
+                        T result = func(state->cancel.Token());
+                        if (! state->cancel.IsCancelled()) state->result.emplace(std::move(result));
+                    } catch (...) {
+                        state->error = std::current_exception();
+                    }
+                }
+                Finish(state);
+            }, priority);
+        }
+
+        // asks the running evaluation to stop; it still completes, without a value unless it had one already
+        void Cancel() {
+            if (_state) _state->cancel.Cancel();
+        }
+
+        // evaluates func(value) once this one has a value; an error or cancellation is passed on instead
+        template<typename F, typename U = std::invoke_result_t<F, T const &>>
+        Async<U> Then(F && func, Priority const priority = Priority::Normal) const {
+            if (! _state) throw std::runtime_error("nothing to continue.");
+            Async<U> next;
+            auto     child = std::make_shared<typename Async<U>::State>();
+            next._state    = child;
+            OnFinish(_state, [parent = _state, child, priority, func = std::forward<F>(func)]() {
+                Executor::Instance().Submit([parent, child, func]() {
+                    if (child->cancel.IsCancelled() || parent->error) {
+                        child->error = parent->error;
+                    } else if (parent->result) {
+                        try {
+                            child->result.emplace(func(*parent->result));
+                        } catch (...) {
+                            child->error = std::current_exception();
+                        }
+                    }
+                    Async<U>::Finish(child);
+                }, priority);
+            });
+            return next;
+        }
+
+        bool HasValue() const { return IsCompleted() && _state->result.has_value(); }
 
         T const & Value() const {
             if (HasValue())
-                return _result.value();
+                return _state->result.value();
+            else if (IsCompleted() && _state->error)
+                std::rethrow_exception(_state->error);
             else
                 throw std::runtime_error("result is not ready.");
         }
 
         T const & ValueOr(T const & alt) const {
             if (HasValue())
-                return _result.value();
+                return _state->result.value();
             else
                 return alt;
         }
 
+        // rethrows what the evaluation threw; throws std::runtime_error if it was cancelled or never started
         T const & WaitForValue() {
-            if (_thread.joinable()) _thread.join();
-            return _result.value();
+            if (! _state) throw std::runtime_error("no evaluation is pending.");
+            Wait(_state);
+            if (_state->error) std::rethrow_exception(_state->error);
+            if (! _state->result) throw std::runtime_error("evaluation was cancelled.");
+            return _state->result.value();
         }
 
         bool IsCompleted() const {
-          return _completed.load();
+          return _state && _state->done.load();
         }
 
     private:
-        std::thread     _thread;
-        std::atomic_bool _completed = false;
-        std::optional<T> _result;
+        template<typename>
+        friend class Async;
+
+        struct State {
+            std::atomic_bool                   done = false;
+            std::optional<T>                   result;
+            std::exception_ptr                 error;
+            CancellationSource                 cancel;
+            std::mutex                         mutex;
+            std::condition_variable            finished;
+            std::vector<std::function<void()>> next;
+        };
+
+        std::shared_ptr<State>              _state;
+        std::vector<std::shared_ptr<State>> _superseded;   // replaced but maybe still running; waited for on destruction
+
+        static void Finish(std::shared_ptr<State> const & state) {
+            std::vector<std::function<void()>> next;
+            {
+                std::lock_guard lock(state->mutex);
+                state->done.store(true);
+                next.swap(state->next);
+            }
+            state->finished.notify_all();
+            for (auto & continuation : next) continuation();
+        }
+
+        static void OnFinish(std::shared_ptr<State> const & state, std::function<void()> && continuation) {
+            {
+                std::lock_guard lock(state->mutex);
+                if (! state->done.load()) {
+                    state->next.push_back(std::move(continuation));
+                    return;
+                }
+            }
+            continuation();
+        }
+
+        // a worker keeps running other tasks meanwhile, since the one awaited may still be queued behind it
+        static void Wait(std::shared_ptr<State> const & state) {
+            auto & executor = Executor::Instance();
+            if (executor.InWorker()) {
+                while (! state->done.load())
+                    if (! executor.RunOne()) std::this_thread::yield();
+            } else {
+                std::unique_lock lock(state->mutex);
+                state->finished.wait(lock, [&]() { return state->done.load(); });
+            }
+        }
+
+        void Supersede() {
+            std::erase_if(_superseded, [](auto const & state) { return state->done.load(); });
+            if (_state) {
+                _state->cancel.Cancel();
+                _superseded.push_back(std::move(_state));
+            }
+            _state.reset();
+        }
+
+        void Drain() {
+            Supersede();
+            for (auto const & state : _superseded) Wait(state);
+            _superseded.clear();
+        }
     };
 }
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VCX::Engine {
+    // read side of a cancellation flag; a default-constructed token is never cancelled.
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        bool IsCancelled() const { return _flag && _flag->load(std::memory_order_relaxed); }
+
+    private:
+        friend class CancellationSource;
+
+        explicit CancellationToken(std::shared_ptr<std::atomic_bool const> flag): _flag(std::move(flag)) { }
+
+        std::shared_ptr<std::atomic_bool const> _flag;
+    };
+
+    // owner side: tasks holding one of its tokens are expected to check it and return early.
+    class CancellationSource {
+    public:
+        void              Cancel() { _flag->store(true, std::memory_order_relaxed); }
+        bool              IsCancelled() const { return _flag->load(std::memory_order_relaxed); }
+        CancellationToken Token() const { return CancellationToken(_flag); }
+
+    private:
+        std::shared_ptr<std::atomic_bool> _flag = std::make_shared<std::atomic_bool>(false);
+    };
+
+    // the worker threads shared by every CPU-side job: async evaluations, parallel loops and batch tools.
+    // Each worker owns a deque it pushes to and pops from at the back; idle workers steal from the front of
+    // the others. Tasks submitted from outside the pool wait in a shared queue, high-priority ones in their own.
+    class Executor {
+    public:
+        enum class Priority { Normal, High };
+
+        static Executor & Instance() {
+            static Executor executor;
+            return executor;
+        }
+
+        ~Executor() {
+            {
+                std::lock_guard lock(_sleep);
+                _stopping = true;
+            }
+            _wake.notify_all();
+            for (auto & worker : _workers) worker.join();
+        }
+
+        std::size_t Size() const { return _workers.size(); }
+
+        // true on one of this executor's worker threads
+        bool InWorker() const { return _index >= 0; }
+
+        void Submit(std::function<void()> && task, Priority const priority = Priority::Normal) {
+            Queue & queue = priority == Priority::High ? _high : InWorker() ? *_queues[_index] : _shared;
+            // counted before it is visible, so a thief can never take it first and drive the count below zero
+            _pending.fetch_add(1);
+            {
+                std::lock_guard lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            {
+                std::lock_guard lock(_sleep);
+            }
+            _wake.notify_one();
+        }
+
+        // runs one pending task on the calling thread; false if there was none.
+        // Lets a thread that must wait keep the pool moving instead of blocking a worker.
+        bool RunOne() {
+            std::function<void()> task;
+            if (! Take(task)) return false;
+            task();
+            return true;
+        }
+
+    private:
+        struct Queue {
+            std::mutex                         mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        Executor() {
+            std::size_t const count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+            for (std::size_t i = 0; i < count; ++i) _queues.push_back(std::make_unique<Queue>());
+            for (std::size_t i = 0; i < count; ++i)
+                _workers.emplace_back([this, i]() { Work(int(i)); });
+        }
+
+        static bool PopBack(Queue & queue, std::function<void()> & task) {
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) return false;
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+
+        static bool PopFront(Queue & queue, std::function<void()> & task) {
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) return false;
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+
+        bool Take(std::function<void()> & task) {
+            if (_pending.load() == 0) return false;
+            bool found = PopFront(_high, task) || (InWorker() && PopBack(*_queues[_index], task)) || PopFront(_shared, task);
+            for (std::size_t i = 1; ! found && i <= _queues.size(); ++i)
+                found = PopFront(*_queues[(_index + i) % _queues.size()], task);
+            if (found) _pending.fetch_sub(1);
+            return found;
+        }
+
+        void Work(int const index) {
+            _index = index;
+            while (true) {
+                std::function<void()> task;
+                if (Take(task)) {
+                    task();
+                    continue;
+                }
+                std::unique_lock lock(_sleep);
+                _wake.wait(lock, [this]() { return _stopping || _pending.load() > 0; });
+                if (_stopping && _pending.load() == 0) return;
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        Queue                               _high;
+        Queue                               _shared;
+        std::vector<std::thread>            _workers;
+        std::atomic_size_t                  _pending = 0;
+        std::mutex                          _sleep;
+        std::condition_variable             _wake;
+        bool                                _stopping = false;
+
+        static inline thread_local int _index = -1;
+    };
+}
@@ -1,11 +1,30 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
 
 #include <glm/glm.hpp>
 
+// GCC and Clang build the x86 kernels for their ISA whatever the target flags and pick one from the running CPU;
+// elsewhere they are compiled in only when the target itself has AVX2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define VCX_BATCH_AVX2  __attribute__((target("avx2")))
+    #define VCX_BATCH_SSE41 __attribute__((target("sse4.1")))
+    #define VCX_BATCH_HAS(isa) (__builtin_cpu_init(), __builtin_cpu_supports(isa))
+#elif defined(__AVX2__)
+    #include <immintrin.h>
+    #define VCX_BATCH_AVX2
+    #define VCX_BATCH_SSE41
+    #define VCX_BATCH_HAS(isa) true
+#endif
+
 namespace VCX::Engine {
     template<typename T>
     concept TextureFormat = requires(typename T::Encoded e, typename T::Decoded d) {
@@ -14,6 +33,140 @@ namespace VCX::Engine {
     };
 
     namespace Formats {
+        /** Span-level kernels behind the formats' Row entry points. The AVX2 / SSE4.1 paths are chosen at
+         *  run time from the CPU (see VCX_BATCH_HAS), the scalar loop finishes the tail (or does all the work
+         *  on other CPUs); every path gives the same bytes as the per-texel Encode / Decode. */
+        namespace Batch {
+#if defined(VCX_BATCH_HAS)
+            namespace Detail {
+                inline bool HasAVX2() {
+                    static bool const has = VCX_BATCH_HAS("avx2");
+                    return has;
+                }
+
+                inline bool HasSSE41() {
+                    static bool const has = VCX_BATCH_HAS("sse4.1");
+                    return has;
+                }
+
+                // each kernel starts at texel or channel `i` and returns where the scalar loop takes over
+                VCX_BATCH_AVX2 inline std::size_t DecodeUnorm8AVX2(std::uint8_t const * in, float * out, std::size_t const n, float const scale, std::size_t i) {
+                    __m256 const s8 = _mm256_set1_ps(scale);
+                    for (; i + 8 <= n; i += 8) {
+                        __m128i const b = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(in + i));
+                        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b)), s8));
+                    }
+                    return i;
+                }
+
+                VCX_BATCH_SSE41 inline std::size_t DecodeUnorm8SSE41(std::uint8_t const * in, float * out, std::size_t const n, float const scale, std::size_t i) {
+                    __m128 const s4 = _mm_set1_ps(scale);
+                    for (; i + 4 <= n; i += 4) {
+                        std::int32_t word;
+                        std::memcpy(&word, in + i, 4);
+                        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(word))), s4));
+                    }
+                    return i;
+                }
+
+                VCX_BATCH_AVX2 inline std::size_t EncodeUnorm8AVX2(float const * in, std::uint8_t * out, std::size_t const n, float const scale, std::size_t i) {
+                    __m256 const s8 = _mm256_set1_ps(scale), zero8 = _mm256_setzero_ps(), one8 = _mm256_set1_ps(1), half8 = _mm256_set1_ps(.5f);
+                    for (; i + 8 <= n; i += 8) {
+                        __m256 const  v = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), zero8), one8), s8);
+                        __m256 const  f = _mm256_floor_ps(v);
+                        __m256 const  r = _mm256_add_ps(f, _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(v, f), half8, _CMP_GE_OQ), one8));
+                        __m256i const w = _mm256_cvttps_epi32(r);
+                        __m128i const h = _mm_packs_epi32(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+                        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(h, h));
+                    }
+                    return i;
+                }
+
+                VCX_BATCH_SSE41 inline std::size_t EncodeUnorm8SSE41(float const * in, std::uint8_t * out, std::size_t const n, float const scale, std::size_t i) {
+                    __m128 const s4 = _mm_set1_ps(scale), zero4 = _mm_setzero_ps(), one4 = _mm_set1_ps(1), half4 = _mm_set1_ps(.5f);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128 const  v = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero4), one4), s4);
+                        __m128 const  f = _mm_floor_ps(v);
+                        __m128 const  r = _mm_add_ps(f, _mm_and_ps(_mm_cmpge_ps(_mm_sub_ps(v, f), half4), one4));
+                        __m128i const h = _mm_packs_epi32(_mm_cvttps_epi32(r), _mm_setzero_si128());
+                        std::int32_t const word = _mm_cvtsi128_si32(_mm_packus_epi16(h, h));
+                        std::memcpy(out + i, &word, 4);
+                    }
+                    return i;
+                }
+
+                VCX_BATCH_SSE41 inline std::size_t DropAlphaSSE41(std::uint8_t const * in, std::uint8_t * out, std::size_t const texels) {
+                    std::size_t i = 0;
+                    __m128i const mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+                    for (; i + 4 <= texels; i += 4) {
+                        __m128i const v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i * 4)), mask);
+                        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i * 3), v);
+                        std::int32_t const word = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+                        std::memcpy(out + i * 3 + 8, &word, 4);
+                    }
+                    return i;
+                }
+
+                VCX_BATCH_SSE41 inline std::size_t AddAlphaSSE41(std::uint8_t const * in, std::uint8_t * out, std::size_t const texels, std::uint8_t const alpha) {
+                    std::size_t i = 0;
+                    __m128i const mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+                    __m128i const fill = _mm_set1_epi32(std::int32_t(std::uint32_t(alpha) << 24));
+                    // each step loads 16 bytes for 12, so stop while two texels of slack remain
+                    for (; i + 6 <= texels; i += 4) {
+                        __m128i const v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i * 3)), mask);
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 4), _mm_or_si128(v, fill));
+                    }
+                    return i;
+                }
+            } // namespace Detail
+#endif
+
+            inline void DecodeUnorm8(std::uint8_t const * in, float * out, std::size_t const n, float const scale) {
+                std::size_t i = 0;
+#if defined(VCX_BATCH_HAS)
+                if (Detail::HasAVX2()) i = Detail::DecodeUnorm8AVX2(in, out, n, scale, i);
+                if (Detail::HasSSE41()) i = Detail::DecodeUnorm8SSE41(in, out, n, scale, i);
+#endif
+                for (; i < n; ++i) out[i] = float(in[i]) * scale;
+            }
+
+            // round half away from zero like std::round: floor, then step up when the fraction is at least .5
+            inline void EncodeUnorm8(float const * in, std::uint8_t * out, std::size_t const n, float const scale) {
+                std::size_t i = 0;
+#if defined(VCX_BATCH_HAS)
+                if (Detail::HasAVX2()) i = Detail::EncodeUnorm8AVX2(in, out, n, scale, i);
+                if (Detail::HasSSE41()) i = Detail::EncodeUnorm8SSE41(in, out, n, scale, i);
+#endif
+                // the same rounding on scalars, without a call into libm per channel
+                for (; i < n; ++i) {
+                    float const v = std::clamp<float>(in[i], 0, 1) * scale;
+                    int const   f = int(v);
+                    out[i] = std::uint8_t(f + (v - float(f) >= .5f));
+                }
+            }
+
+            // 4-channel texels to 3 channels, dropping the last
+            inline void DropAlpha(std::uint8_t const * in, std::uint8_t * out, std::size_t const texels) {
+                std::size_t i = 0;
+#if defined(VCX_BATCH_HAS)
+                if (Detail::HasSSE41()) i = Detail::DropAlphaSSE41(in, out, texels);
+#endif
+                for (; i < texels; ++i) std::memcpy(out + i * 3, in + i * 4, 3);
+            }
+
+            // 3-channel texels to 4 channels, the new one set to `alpha`
+            inline void AddAlpha(std::uint8_t const * in, std::uint8_t * out, std::size_t const texels, std::uint8_t const alpha) {
+                std::size_t i = 0;
+#if defined(VCX_BATCH_HAS)
+                if (Detail::HasSSE41()) i = Detail::AddAlphaSSE41(in, out, texels, alpha);
+#endif
+                for (; i < texels; ++i) {
+                    std::memcpy(out + i * 4, in + i * 3, 3);
+                    out[i * 4 + 3] = alpha;
+                }
+            }
+        } // namespace Batch
+
         struct R8 {
             using Decoded = float;
             using Encoded = unsigned char;
@@ -26,11 +179,23 @@ namespace VCX::Engine {
                 return std::round(std::clamp<float>(o, 0, 1) * _enc);
             }
 
+            static void DecodeRow(std::span<Encoded const> const in, std::span<Decoded> const out) {
+                assert(in.size() == out.size());
+                Batch::DecodeUnorm8(in.data(), out.data(), in.size(), _dec);
+            }
+
+            static void EncodeRow(std::span<Decoded const> const in, std::span<Encoded> const out) {
+                assert(in.size() == out.size());
+                Batch::EncodeUnorm8(in.data(), out.data(), in.size(), _enc);
+            }
+
         private:
             static constexpr float _enc { 255. };
             static constexpr float _dec { 1. / 255. };
         };
 
+        struct RGBA8;
+
         struct RGB8 {
             using Decoded = glm::vec3;
             using Encoded = glm::u8vec3;
@@ -47,6 +212,29 @@ namespace VCX::Engine {
                 };
             }
 
+            static void DecodeRow(std::span<Encoded const> const in, std::span<Decoded> const out) {
+                assert(in.size() == out.size());
+                Batch::DecodeUnorm8(&in.data()->r, &out.data()->r, in.size() * 3, _dec);
+            }
+
+            static void EncodeRow(std::span<Decoded const> const in, std::span<Encoded> const out) {
+                assert(in.size() == out.size());
+                Batch::EncodeUnorm8(&in.data()->r, &out.data()->r, in.size() * 3, _enc);
+            }
+
+            template<TextureFormat NewFormat>
+                requires std::is_same_v<NewFormat, RGBA8>
+            static typename NewFormat::Encoded Cast(const Encoded & val) {
+                return { val.r, val.g, val.b, 255 };
+            }
+
+            template<TextureFormat NewFormat>
+                requires std::is_same_v<NewFormat, RGBA8>
+            static void CastRow(std::span<Encoded const> const in, std::span<typename NewFormat::Encoded> const out) {
+                assert(in.size() == out.size());
+                Batch::AddAlpha(&in.data()->r, &out.data()->r, in.size(), 255);
+            }
+
         private:
             static constexpr float _enc { 255. };
             static constexpr float _dec { 1. / 255. };
@@ -69,6 +257,16 @@ namespace VCX::Engine {
                 };
             }
 
+            static void DecodeRow(std::span<Encoded const> const in, std::span<Decoded> const out) {
+                assert(in.size() == out.size());
+                Batch::DecodeUnorm8(&in.data()->r, &out.data()->r, in.size() * 4, _dec);
+            }
+
+            static void EncodeRow(std::span<Decoded const> const in, std::span<Encoded> const out) {
+                assert(in.size() == out.size());
+                Batch::EncodeUnorm8(&in.data()->r, &out.data()->r, in.size() * 4, _enc);
+            }
+
             template<TextureFormat NewFormat>
                 requires std::is_same_v<NewFormat, RGB8>
             static typename NewFormat::Encoded Cast(const Encoded & val) {
@@ -76,6 +274,13 @@ namespace VCX::Engine {
                     return { val.r, val.g, val.b };
             }
 
+            template<TextureFormat NewFormat>
+                requires std::is_same_v<NewFormat, RGB8>
+            static void CastRow(std::span<Encoded const> const in, std::span<typename NewFormat::Encoded> const out) {
+                assert(in.size() == out.size());
+                Batch::DropAlpha(&in.data()->r, &out.data()->r, in.size());
+            }
+
         private:
             static constexpr float _enc { 255. };
             static constexpr float _dec { 1. / 255. };
@@ -131,6 +336,9 @@ namespace VCX::Engine {
             static constexpr float _enc { 16777215. };
             static constexpr float _dec { 1. / 16777215. };
         };
+        // the Row entry points view texel arrays as plain channel arrays
+        static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::vec4) == 4 * sizeof(float));
+        static_assert(sizeof(glm::u8vec3) == 3 && sizeof(glm::u8vec4) == 4);
     } // namespace Formats
 
 } // namespace VCX::Engine
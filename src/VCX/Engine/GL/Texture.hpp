@@ -122,6 +122,20 @@ namespace VCX::Engine::GL {
             glGenerateMipmap(TypeEnum);
         }
 
+        template<TextureFormat Format>
+        void UpdateRegion(Texture2D<Format> const & texture, std::size_t const x, std::size_t const y) const
+            requires std::is_same_v<TypeTrait, Texture2DTrait> {
+            auto const useThis { Use() };
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(
+                GL_TEXTURE_2D, 0,
+                x, y, texture.GetSizeX(), texture.GetSizeY(),
+                FormatEnumOf<Format>, PixelTypeEnumOf<Format>,
+                texture.GetBytes().data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(TypeEnum);
+        }
+
         template<TextureFormat Format>
         auto Download() const {
             auto const useThis { Use() };
@@ -174,7 +188,7 @@ namespace VCX::Engine::GL {
             int height;
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-            Texture2D<Format> ret(width, height);
+            auto ret = Texture2D<Format>::Uninitialized({ std::size_t(width), std::size_t(height) });
             glGetTexImage(GL_TEXTURE_2D, 0,
                           FormatEnumOf<Format>, PixelTypeEnumOf<Format>,
                           reinterpret_cast<void *>(const_cast<std::byte *>(ret.GetBytes().data())));
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "Engine/Executor.hpp"
+
+namespace VCX::Engine {
+    // runs func(i) for every i in [begin, end) on the executor; the calling thread helps and returns once all are done.
+    // Once `token` is cancelled, indices not yet started are skipped.
+    inline void ParallelFor(int const begin, int const end, std::function<void(int)> const & func, CancellationToken const & token = {}) {
+        if (end - begin <= 1) {
+            for (int i = begin; i < end && ! token.IsCancelled(); ++i) func(i);
+            return;
+        }
+
+        struct State {
+            std::atomic_int         next;
+            std::atomic_int         done = 0;
+            std::mutex              mutex;
+            std::condition_variable finished;
+        };
+        auto state  = std::make_shared<State>();
+        state->next = begin;
+        int const total = end - begin;
+
+        // late helpers find no index left and never touch func or token
+        auto drain = [state, end, total, &func, &token]() {
+            int i;
+            while ((i = state->next.fetch_add(1)) < end) {
+                if (! token.IsCancelled()) func(i);
+                if (state->done.fetch_add(1) + 1 == total) {
+                    std::lock_guard lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+        std::size_t const helpers = std::min<std::size_t>(Executor::Instance().Size(), total - 1);
+        for (std::size_t i = 0; i < helpers; ++i) Executor::Instance().Submit(drain);
+        drain();
+
+        std::unique_lock lock(state->mutex);
+        state->finished.wait(lock, [&]() { return state->done.load() == total; });
+    }
+}
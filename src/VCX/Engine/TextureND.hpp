@@ -2,18 +2,72 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <span>
+#include <type_traits>
 #include <vector>
 
+#include "Engine/AlignedAllocator.hpp"
 #include "Engine/Formats.hpp"
 #include "Engine/prelude.hpp"
 
 namespace VCX::Engine {
+    /** Non-owning 2D window of texels, `stride` texels apart row to row. Access is checked by assert only,
+     *  so it compiles down to pointer arithmetic when NDEBUG is set. */
+    template<typename T>
+    class ImageView {
+    private:
+        T *         _data   = nullptr;
+        std::size_t _width  = 0;
+        std::size_t _height = 0;
+        std::size_t _stride = 0;
+
+    public:
+        ImageView() = default;
+
+        ImageView(T * data, std::size_t const width, std::size_t const height, std::size_t const stride):
+            _data(data), _width(width), _height(height), _stride(stride) { }
+
+        template<typename U>
+            requires std::is_same_v<T, U const>
+        ImageView(ImageView<U> const & o):
+            _data(o.Data()), _width(o.GetSizeX()), _height(o.GetSizeY()), _stride(o.GetStride()) { }
+
+        T *         Data() const { return _data; }
+        std::size_t GetSizeX() const { return _width; }
+        std::size_t GetSizeY() const { return _height; }
+        std::size_t GetStride() const { return _stride; }
+
+        T * Row(std::size_t const y) const {
+            assert(y < _height);
+            return _data + y * _stride;
+        }
+
+        T & operator()(std::size_t const x, std::size_t const y) const {
+            assert(x < _width && y < _height);
+            return _data[y * _stride + x];
+        }
+
+        ImageView Sub(std::size_t const x, std::size_t const y, std::size_t const width, std::size_t const height) const {
+            assert(x + width <= _width && y + height <= _height);
+            return ImageView(_data + y * _stride + x, width, height, _stride);
+        }
+    };
+
     template<std::size_t Dim, TextureFormat Format>
         requires (Dim == 1 || Dim == 2 || Dim == 3)
     class TextureND {
     private:
-        std::array<std::size_t, Dim>          _size;
-        std::vector<typename Format::Encoded> _data;
+        using Storage = std::vector<typename Format::Encoded, AlignedAllocator<typename Format::Encoded>>;
+
+        std::array<std::size_t, Dim> _size;
+        Storage                      _data;
+
+        static std::size_t CountOf(std::array<std::size_t, Dim> const & o) {
+            std::size_t n = 1;
+            for (auto const d : o) n *= d;
+            return n;
+        }
 
         /** Throws std::out_of_range if a invalid index is given */
         constexpr std::size_t GetIndexAt(std::array<std::size_t, Dim> const & o) const {
@@ -47,32 +101,44 @@ namespace VCX::Engine {
         TextureND() { _size.fill(0); }
 
         explicit TextureND(std::array<std::size_t, Dim> const & o):
-            _size(o) {
-            if constexpr (Dim == 1) _data.resize(o[0]);
-            if constexpr (Dim == 2) _data.resize(o[0] * o[1]);
-            if constexpr (Dim == 3) _data.resize(o[0] * o[1] * o[2]);
-        }
+            _size(o), _data(CountOf(o), typename Format::Encoded {}) { }
 
         explicit TextureND(std::size_t const sizeX) requires (Dim == 1) :
-            _size({ sizeX }), _data(sizeX) { }
+            TextureND(std::array<std::size_t, Dim> { sizeX }) { }
 
         TextureND(std::size_t const sizeX, std::size_t const sizeY) requires (Dim == 2) :
-            _size({ sizeX, sizeY }), _data(sizeX * sizeY) { }
+            TextureND(std::array<std::size_t, Dim> { sizeX, sizeY }) { }
 
         TextureND(std::size_t const sizeX, std::size_t const sizeY, std::size_t const sizeZ) requires (Dim == 3) :
-            _size({ sizeX, sizeY, sizeZ }), _data(sizeX * sizeY * sizeZ) { }
+            TextureND(std::array<std::size_t, Dim> { sizeX, sizeY, sizeZ }) { }
+
+        /** Texels are left unwritten: for buffers about to be cleared, drawn or copied over in full. */
+        static TextureND Uninitialized(std::array<std::size_t, Dim> const & o, bool const hugePages = false) {
+            TextureND result;
+            result._size = o;
+            result._data = Storage(AlignedAllocator<typename Format::Encoded>(hugePages));
+            result._data.resize(CountOf(o));
+            return result;
+        }
+
+        /** Every texel set to `value` in the single pass that first touches the memory. */
+        static TextureND Filled(std::array<std::size_t, Dim> const & o, typename Format::Decoded const & value, bool const hugePages = false) {
+            TextureND result;
+            result._size = o;
+            result._data = Storage(CountOf(o), Format::Encode(value), AlignedAllocator<typename Format::Encoded>(hugePages));
+            return result;
+        }
 
         template<TextureFormat NewFormat>
             requires requires (typename Format::Encoded a) { { Format::template Cast<NewFormat>(a) } -> std::same_as<typename NewFormat::Encoded>; }
-        TextureND<Dim, NewFormat> Cast() {
-            TextureND<Dim, NewFormat> result(_size);
-            auto sourceIter = _data.begin();
-            auto resultIter = result._data.begin();
-            while (sourceIter != _data.end()) {
-                *resultIter = Format::template Cast<NewFormat>(*sourceIter);
-                ++ sourceIter;
-                ++ resultIter;
-            }
+        TextureND<Dim, NewFormat> Cast() const {
+            auto result = TextureND<Dim, NewFormat>::Uninitialized(_size);
+            auto target = result.GetData();
+            if constexpr (requires { Format::template CastRow<NewFormat>(std::span(_data), std::span(target, _data.size())); })
+                Format::template CastRow<NewFormat>(std::span(_data), std::span(target, _data.size()));
+            else
+                for (std::size_t i = 0; i < _data.size(); ++i)
+                    target[i] = Format::template Cast<NewFormat>(_data[i]);
             return result;
         }
 
@@ -104,6 +170,38 @@ namespace VCX::Engine {
         typename Format::Decoded const At(std::size_t const x, std::size_t const y) const requires (Dim == 2) { return At({ x, y }); }
         typename Format::Decoded const At(std::size_t const x, std::size_t const y, std::size_t const z) const requires (Dim == 3) { return At({ x, y, z }); }
         
+        /** Raw texels: no range checks beyond assert and no encode/decode. */
+        typename Format::Encoded *       GetData() { return _data.data(); }
+        typename Format::Encoded const * GetData() const { return _data.data(); }
+
+        typename Format::Encoded * Row(std::size_t const y) requires (Dim == 2) {
+            assert(y < _size[1]);
+            return _data.data() + y * _size[0];
+        }
+
+        typename Format::Encoded const * Row(std::size_t const y) const requires (Dim == 2) {
+            assert(y < _size[1]);
+            return _data.data() + y * _size[0];
+        }
+
+        typename Format::Encoded & Texel(std::size_t const x, std::size_t const y) requires (Dim == 2) {
+            assert(x < _size[0] && y < _size[1]);
+            return _data[y * _size[0] + x];
+        }
+
+        typename Format::Encoded const & Texel(std::size_t const x, std::size_t const y) const requires (Dim == 2) {
+            assert(x < _size[0] && y < _size[1]);
+            return _data[y * _size[0] + x];
+        }
+
+        ImageView<typename Format::Encoded> GetView() requires (Dim == 2) {
+            return ImageView<typename Format::Encoded>(_data.data(), _size[0], _size[1], _size[0]);
+        }
+
+        ImageView<typename Format::Encoded const> GetView() const requires (Dim == 2) {
+            return ImageView<typename Format::Encoded const>(_data.data(), _size[0], _size[1], _size[0]);
+        }
+
         void Fill(typename Format::Decoded const & o) {
             std::fill(_data.begin(), _data.end(), Format::Encode(o));
         }
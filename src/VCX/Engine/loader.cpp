@@ -1,5 +1,10 @@
 #include <filesystem>
 #include <fstream>
+#if defined(_WIN32)
+    #include <stdlib.h>
+#elif defined(PLATFORM_MACOSX)
+    #include <mach-o/dyld.h>
+#endif
 
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
@@ -105,6 +110,31 @@ namespace VCX::Engine {
         }
     }
 
+    static std::filesystem::path ExecutableDirectory() {
+        std::error_code ec;
+#if defined(_WIN32)
+        wchar_t * name = nullptr;
+        if (_get_wpgmptr(&name) != 0 || ! name) return {};
+        std::filesystem::path exe { name };
+#elif defined(PLATFORM_MACOSX)
+        char     buffer[4096];
+        uint32_t size = sizeof(buffer);
+        if (_NSGetExecutablePath(buffer, &size) != 0) return {};
+        std::filesystem::path exe { std::filesystem::canonical(buffer, ec) };
+#else
+        std::filesystem::path exe { std::filesystem::read_symlink("/proc/self/exe", ec) };
+#endif
+        return ec ? std::filesystem::path {} : exe.parent_path();
+    }
+
+    std::filesystem::path ResolveAsset(std::filesystem::path const & fileName) {
+        if (fileName.is_absolute() || std::filesystem::exists(fileName)) return fileName;
+        static std::filesystem::path const directory { ExecutableDirectory() };
+        if (directory.empty()) return fileName;
+        auto candidate { directory / fileName };
+        return std::filesystem::exists(candidate) ? candidate : fileName;
+    }
+
     Texture2D<Formats::R8> LoadImageGray(std::filesystem::path const & fileName, bool const flipped) {
         auto const buf { LoadBytes(fileName) };
         int        width {}, height {}, channels {};
@@ -118,7 +148,7 @@ namespace VCX::Engine {
                 &channels,
                 1)
         };
-        Texture2D<Formats::R8> texture(width, height);
+        auto texture = Texture2D<Formats::R8>::Uninitialized({ std::size_t(width), std::size_t(height) });
         std::memcpy(
             reinterpret_cast<void *>(const_cast<std::byte *>(texture.GetBytes().data())),
             image,
@@ -140,7 +170,7 @@ namespace VCX::Engine {
                 &channels,
                 3)
         };
-        Texture2D<Formats::RGB8> texture(width, height);
+        auto texture = Texture2D<Formats::RGB8>::Uninitialized({ std::size_t(width), std::size_t(height) });
         std::memcpy(
             reinterpret_cast<void *>(const_cast<std::byte *>(texture.GetBytes().data())),
             image,
@@ -151,6 +181,10 @@ namespace VCX::Engine {
 
     Texture2D<Formats::RGBA8> LoadImageRGBA(std::filesystem::path const & fileName, bool const flipped) {
         auto const buf { LoadBytes(fileName) };
+        return LoadImageRGBA(std::span<std::byte const>(buf), flipped);
+    }
+
+    Texture2D<Formats::RGBA8> LoadImageRGBA(std::span<std::byte const> const buf, bool const flipped) {
         int        width {}, height {}, channels {};
         stbi_set_flip_vertically_on_load(flipped);
         auto const image {
@@ -162,7 +196,11 @@ namespace VCX::Engine {
                 &channels,
                 4)
         };
-        Texture2D<Formats::RGBA8> texture(width, height);
+        if (! image) {
+            spdlog::error("VCX::Engine::LoadImageRGBA: {}", stbi_failure_reason());
+            return {};
+        }
+        auto texture = Texture2D<Formats::RGBA8>::Uninitialized({ std::size_t(width), std::size_t(height) });
         std::memcpy(
             reinterpret_cast<void *>(const_cast<std::byte *>(texture.GetBytes().data())),
             image,
@@ -10,10 +10,15 @@ namespace VCX::Engine {
     // If the file does not exist, this function returns an empty vector,
     // and an error will be emitted to spdlog.
     std::vector<std::byte> LoadBytes(std::filesystem::path const & fileName);
+    // a relative asset path as found from the working directory or else from the directory of the running
+    // executable, where the build copies assets/; the path itself when neither has it.
+    std::filesystem::path ResolveAsset(std::filesystem::path const & fileName);
 
     Texture2D<Formats::R8>    LoadImageGray(std::filesystem::path const & fileName, bool const flipped = false);
     Texture2D<Formats::RGB8>  LoadImageRGB (std::filesystem::path const & fileName, bool const flipped = false);
     Texture2D<Formats::RGBA8> LoadImageRGBA(std::filesystem::path const & fileName, bool const flipped = false);
+    // decodes an encoded image (png, jpg, ...) already in memory; an empty texture is returned on failure.
+    Texture2D<Formats::RGBA8> LoadImageRGBA(std::span<std::byte const> bytes, bool const flipped = false);
 
     SurfaceMesh LoadSurfaceMesh(std::filesystem::path const & fileName, bool const simplified = false);
 
@@ -1,12 +1,16 @@
-#include <stb_image_write.h>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <spdlog/spdlog.h>
 
 #include "Labs/0-GettingStarted/CaseSVG.h"
 #include "Labs/Common/ImGuiHelper.h"
 #include <iostream>
 #include "CaseSVG.h"
+#include "SVGExport.h"
 #include "SVGParser.h"
+#include "SVGScheduler.h"
 #include "portable-file-dialogs.h"
 
 namespace VCX::Labs::GettingStarted { 
@@ -17,8 +21,6 @@ namespace VCX::Labs::GettingStarted {
     }
 
     CaseSVG::~CaseSVG() {
-        for (auto s : _shapes) delete s;
-        _shapes.clear();
     }
     
     void CaseSVG::OnSetupPropsUI() {
@@ -27,12 +29,35 @@ namespace VCX::Labs::GettingStarted {
             auto sel = pfd::open_file("Open SVG", ".", {"SVG Files", "*.svg"}).result();
             if (!sel.empty()) {
                 _pathname = sel[0];
+                // an explicit load re-parses even the file already shown, which may have changed on disk
+                _recordedPath.clear();
                 auto [x, y] = SVGParser::GetSceneSize(_pathname);
                 _sizex = x, _sizey = y;
                 _recompute = true;
             }
         }
         ImGui::SliderInt("Sample Rate", &_sampleRate, 1, 16);
+        ImGui::Checkbox("Adaptive SSAA", &_adaptive);
+        ImGui::Combo("MSAA", &_msaa, "Off\0" "2x\0" "4x\0" "8x\0" "16x\0" "32x\0");
+        ImGui::Checkbox("Blue-noise jitter", &_jitter);
+        if (ImGui::Checkbox("Progressive", &_progressive)) _recompute = true;
+        if (_progressive) ImGui::Text("Samples: %d / %d", _accumulated, ProgressiveSamples);
+        if (ImGui::CollapsingHeader("Edit Element")) {
+            ImGui::InputText("Id", _editId, IM_ARRAYSIZE(_editId));
+            std::string id = _editId;
+            if (ImGui::ColorEdit4("Fill", &_editFill[0]))
+                ApplyEdit("fill", [id, color = _editFill](SVGDisplayList& scene) { return scene.SetFill(id, color); });
+            if (ImGui::ColorEdit4("Stroke", &_editStroke[0]))
+                ApplyEdit("stroke", [id, color = _editStroke](SVGDisplayList& scene) { return scene.SetStroke(id, color); });
+            if (ImGui::Checkbox("Visible", &_editVisible))
+                ApplyEdit("visible", [id, visible = _editVisible](SVGDisplayList& scene) { return scene.SetVisible(id, visible); });
+            if (ImGui::DragFloat2("Offset", &_editOffset[0])) {
+                glm::mat3 transform(1.0f);
+                transform[2] = glm::vec3(_editOffset, 1.0f);
+                ApplyEdit("offset", [id, transform](SVGDisplayList& scene) { return scene.SetTransform(id, transform); });
+            }
+            if (!_editFound) ImGui::TextColored(ImVec4(1, 0, 0, 1), "No element with that id.");
+        }
         if (ImGui::Button("Apply SSAA")) {
             _recompute = true;
         }
@@ -42,21 +67,8 @@ namespace VCX::Labs::GettingStarted {
             if (!destination.empty()) {
                 if (destination.find(".png") == std::string::npos) destination += ".png";
     
-                int w = _lastimg.GetSizeX();
-                int h = _lastimg.GetSizeY();
-                std::vector<uint8_t> pixels;
-                pixels.reserve(w * h * 3);
-    
-                for (int j = 0; j < h; j++) {
-                    for (int i = 0; i < w; i++) {
-                        glm::vec3 color = _lastimg.At(i, j);
-                        pixels.push_back(static_cast<uint8_t>(std::clamp(color.r * 255.0f, 0.0f, 255.0f)));
-                        pixels.push_back(static_cast<uint8_t>(std::clamp(color.g * 255.0f, 0.0f, 255.0f)));
-                        pixels.push_back(static_cast<uint8_t>(std::clamp(color.b * 255.0f, 0.0f, 255.0f)));
-                    }
-                }
-  
-                stbi_write_png(destination.c_str(), w, h, 3, pixels.data(), w * 3);
+                auto png = SVGExport::EncodePNG(_lastimg);
+                if (!png.empty()) SVGExport::WriteFile(destination, png);
             }
         }
         if (_messageTimer > 0.0f) {
@@ -69,14 +81,25 @@ namespace VCX::Labs::GettingStarted {
     
     void CaseSVG::LoadSVG(const std::string& path) {
         if (path.size() == 0) return;
-        // 清理旧数据
-        for (auto s : _shapes) delete s;
-        _shapes.clear();
-    
-        _shapes = SVGParser::ParseFile(path, _sampleRate);
-        // for (auto s : _shapes) {
-        //     std::cout << static_cast<int>(s->type) << "\n";
-        // }
+        // the recorded list replays at any rate up to the one it was flattened for
+        if (path == _recordedPath and _scene.GetDetail() >= _sampleRate) return;
+        _scene = SVGDisplayList::Record(path, _sampleRate);
+        if (path == _recordedPath)
+            for (auto& [control, edit] : _edits) edit(_scene);
+        else _edits.clear();
+        _recordedPath = path;
+        // the caller redraws the whole frame
+        _scene.TakeDamage();
+    }
+
+    // applies `edit` made through `control` to the scene and remembers it for the next recording
+    void CaseSVG::ApplyEdit(const std::string& control, std::function<bool(SVGDisplayList&)> edit) {
+        _editFound = edit(_scene);
+        if (!_editFound) return;
+        // each edit sets absolute values, so a later one through the same control on the same id replaces the earlier
+        std::string key = control + ":" + _editId;
+        std::erase_if(_edits, [&](const auto& entry) { return entry.first == key; });
+        _edits.emplace_back(std::move(key), std::move(edit));
     }
     
     Common::CaseRenderResult CaseSVG::OnRender(std::pair<std::uint32_t, std::uint32_t> const desiredSize) {
@@ -88,17 +111,45 @@ namespace VCX::Labs::GettingStarted {
         if (prex != x or prey != y) _recompute = true;
         prex = x, prey = y;
         _sizex = x, _sizey = y;
-        if (_recompute) {
+        auto damage = _scene.TakeDamage();
+        // progressive passes redraw the whole frame anyway
+        if (!damage.empty() and _progressive) _recompute = true;
+        if (_recompute and _progressive) {
             LoadSVG(_pathname);
-            Common::ImageRGB tempimage = Common::CreatePureImageRGB(x * _sampleRate, y * _sampleRate, glm::vec3{1.0f});
-            _rasterizer.Rasterize(tempimage, _shapes);
-            Common::ImageRGB image = Common::CreatePureImageRGB(x, y, glm::vec3{1.0f});
-            _rasterizer.Supersample(image, tempimage, _sampleRate);
+            _accumulation.assign(std::size_t(x) * y, glm::vec3(0.0f));
+            _accumulated = 0;
+            _progressiveStart = std::chrono::steady_clock::now();
+            AccumulatePass(x, y);
+            _messageTimer = 1.0f;
+            _skipFrame = true;
+            _recompute = false;
+        } else if (_progressive and _accumulated > 0 and _accumulated < ProgressiveSamples) {
+            AccumulatePass(x, y);
+            if (_accumulated == ProgressiveSamples)
+                spdlog::info("SVG progressive render {}x{}: {} samples; took {:.2f} ms", x, y, _accumulated,
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _progressiveStart).count());
+        } else if (_recompute) {
+            LoadSVG(_pathname);
+            auto start = std::chrono::steady_clock::now();
+            SVGRenderPlan plan = SVGScheduler::Plan(
+                SVGScheduler::Measure(_scene, 1.0f, _sampleRate, x, y, _msaa > 0 ? 1 << _msaa : 1), 0, _adaptive);
+            plan.jitter = _jitter and _msaa > 0;
+            // every pixel is written, whichever way the plan splits the frame
+            Common::ImageRGB image = Common::ImageRGB::Uninitialized({ std::size_t(x), std::size_t(y) });
+            SVGScheduler::Render(_scene, _rasterizer, image, 1.0f, plan);
+            _plan = plan;
+            spdlog::info("SVG render {}x{}: {}; took {:.2f} ms", x, y, plan.Describe(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
             _textures[0].Update(image);
             _lastimg = image;
             _messageTimer = 1.0f;
             _skipFrame = true;
             _recompute = false;
+        } else if (!damage.empty() and _lastimg.GetSizeX() == x and _lastimg.GetSizeY() == y) {
+            auto start = std::chrono::steady_clock::now();
+            for (auto& rect : damage) Repaint(rect);
+            spdlog::info("SVG repaint of {} region(s); took {:.2f} ms", damage.size(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
         }
         return Common::CaseRenderResult {
             .Fixed     = true,         // 代表⽣成的 2D 图像是固定的，即不会随着窗⼝⼤⼩的变化⽽拉伸的
@@ -107,6 +158,40 @@ namespace VCX::Labs::GettingStarted {
         };
     }
     
+    // draws the scene once more at the next offset of the R2 sequence, which starts at the pixel center and
+    // spreads any run of passes evenly over the pixel, then shows the running average
+    void CaseSVG::AccumulatePass(int width, int height) {
+        constexpr float g = 1.32471795724474602596f;   // plastic number
+        float n = float(_accumulated);
+        glm::vec2 offset = glm::fract(glm::vec2(0.5f) + n * glm::vec2(1.0f / g, 1.0f / (g * g)));
+        Common::ImageRGB frame = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(height) });
+        _rasterizer.SetSampleOffset(offset);
+        _scene.Replay(_rasterizer, frame, 1.0f);
+        _accumulated++;
+        float weight = 1.0f / _accumulated;
+        for (int j = 0; j < height; j++)
+            for (int i = 0; i < width; i++) {
+                glm::vec3& sum = _accumulation[std::size_t(j) * width + i];
+                sum += glm::vec3(frame.At(i, j));
+                frame.At(i, j) = sum * weight;
+            }
+        _textures[0].Update(frame);
+        _lastimg = std::move(frame);
+    }
+
+    // redraws the damaged canvas rectangle `rect` into the last frame, as that frame's plan drew it, and uploads just those pixels
+    void CaseSVG::Repaint(const glm::vec4& rect) {
+        int width = _lastimg.GetSizeX(), height = _lastimg.GetSizeY();
+        // a pixel of margin for the antialiased fringe
+        int x0 = std::max(0, (int)std::floor(rect.x) - 1), y0 = std::max(0, (int)std::floor(rect.y) - 1);
+        int x1 = std::min(width, (int)std::ceil(rect.z) + 1), y1 = std::min(height, (int)std::ceil(rect.w) + 1);
+        if (x0 >= x1 or y0 >= y1) return;
+        SVGScheduler::Repaint(_scene, _rasterizer, _lastimg, 1.0f, _plan, { x0, y0, x1 - x0, y1 - y0 });
+        Common::ImageRGB region = Common::ImageRGB::Uninitialized({ std::size_t(x1 - x0), std::size_t(y1 - y0) });
+        for (int j = y0; j < y1; j++) std::copy_n(_lastimg.Row(j) + x0, x1 - x0, region.Row(j - y0));
+        _textures[0].UpdateRegion(region, x0, y0);
+    }
+
     void CaseSVG::OnProcessInput(ImVec2 const & pos) {
         auto         window  = ImGui::GetCurrentWindow();
         bool         hovered = false;
@@ -4,7 +4,13 @@
 #include "Labs/Common/ICase.h"
 #include "Labs/Common/ImageRGB.h"
 #include "SVGData.h"
+#include "SVGDisplayList.h"
 #include "SVGRasterizer.h"
+#include "SVGScheduler.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace VCX::Labs::GettingStarted {
@@ -23,21 +29,44 @@ namespace VCX::Labs::GettingStarted {
     private:
 
         Common::ImageRGB _lastimg;
-        std::vector<Shape*> _shapes;
+        SVGDisplayList _scene;
         std::string _pathname;
+        std::string _recordedPath;   // file _scene was recorded from
         SVGRasterizer _rasterizer;
+        SVGRenderPlan _plan;   // of the last full frame; edits are repainted with the same antialiasing
         float _messageTimer = 0.0f;
         int _sizex = 800;
         int _sizey = 600;
         int _sampleRate = 1;
+        bool _adaptive = false;   // supersample only the tiles edges cross
+        int _msaa = 0;   // coverage samples: off, 2, 4, 8, 16, 32
+        bool _jitter = false;   // blue-noise sample positions for MSAA
+        bool _progressive = false;   // one sample pass per frame, averaged, instead of one blocking render
+        std::vector<glm::vec3> _accumulation;   // summed passes, row-major
+        int _accumulated = 0;   // passes in _accumulation
+        std::chrono::steady_clock::time_point _progressiveStart;
         std::array<Engine::GL::UniqueTexture2D, 2> _textures;
         std::array<Common::ImageRGB, 2>            _empty;
         Engine::Async<Common::ImageRGB>            _task;
+        char _editId[64] = "";   // element the edit controls act on
+        bool _editFound = true;
+        glm::vec4 _editFill = { 0, 0, 0, 1 };
+        glm::vec4 _editStroke = { 0, 0, 0, 1 };
+        glm::vec2 _editOffset = { 0, 0 };   // root user units
+        bool _editVisible = true;
+        // edits that found their element, keyed by control and id with only the latest kept; re-applied whenever
+        // the document is recorded again so the frame keeps matching the panel
+        std::vector<std::pair<std::string, std::function<bool(SVGDisplayList&)>>> _edits;
         bool _enableZoom = true;
         bool _recompute = false;
         bool _skipFrame = false;
 
         void LoadSVG(const std::string& filepath);
+        void ApplyEdit(const std::string& control, std::function<bool(SVGDisplayList&)> edit);
+        void AccumulatePass(int width, int height);
+        void Repaint(const glm::vec4& rect);
+
+        static constexpr int ProgressiveSamples = 256;   // passes before the progressive image is left alone
 
     };
 }
@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <stb_image_write.h>
+
+#include "Engine/Parallel.hpp"
+#include "Labs/0-GettingStarted/SVGDisplayList.h"
+#include "Labs/0-GettingStarted/SVGExport.h"
+#include "Labs/0-GettingStarted/SVGParser.h"
+#include "Labs/0-GettingStarted/SVGRasterizer.h"
+#include "Labs/0-GettingStarted/SVGScheduler.h"
+#include "Labs/0-GettingStarted/SVGSceneCache.h"
+
+using namespace VCX::Labs;
+using namespace VCX::Labs::GettingStarted;
+
+namespace {
+    struct Arguments {
+        std::vector<std::string>           positional;
+        std::map<std::string, std::string> options;
+
+        std::string Get(const std::string& key, const std::string& fallback) const {
+            auto it = options.find(key);
+            return it != options.end() ? it->second : fallback;
+        }
+        int GetInt(const std::string& key, int fallback) const { return std::stoi(Get(key, std::to_string(fallback))); }
+        float GetFloat(const std::string& key, float fallback) const { return std::stof(Get(key, std::to_string(fallback))); }
+    };
+
+    Arguments ParseArguments(int argc, char** argv) {
+        Arguments args;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) == 0 and i + 1 < argc) args.options[arg.substr(2)] = argv[++i];
+            else args.positional.push_back(arg);
+        }
+        return args;
+    }
+
+    SVGDisplayList Load(const Arguments& args, const std::string& input, int detail) {
+        std::string cache = args.Get("cache", "");
+        if (cache.empty()) return SVGDisplayList::Record(input, detail);
+        return SVGSceneCache(cache).Load(input, detail);
+    }
+
+    PNGOptions EncodeOptions(const Arguments& args) {
+        PNGOptions options;
+        options.level = args.GetInt("level", options.level);
+        std::string filter = args.Get("filter", "");
+        if (!filter.empty() and !SVGExport::ParseFilter(filter, options.filter))
+            throw std::invalid_argument("unknown PNG filter: " + filter);
+        return options;
+    }
+
+    double Milliseconds(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // svg-cli render <input.svg> <output.png|ppm|pam> [--scale S] [--ssaa N] [--msaa 2-32] [--jitter 0|1] [--band-mb M] [--cache DIR]
+    // Streams the output in bands of about M MiB of supersampled pixels, so poster sizes never sit in memory whole.
+    int Render(const Arguments& args) {
+        if (args.positional.size() != 2) return 2;
+        float scale = args.GetFloat("scale", 1.0f);
+        int ssaa = std::max(1, args.GetInt("ssaa", 1));
+        std::size_t bandBytes = std::size_t(std::max(1, args.GetInt("band-mb", 64))) << 20;
+        PNGOptions options = EncodeOptions(args);
+        auto start = std::chrono::steady_clock::now();
+        SVGDisplayList list = Load(args, args.positional[0], (int)std::ceil(scale * ssaa));
+        if (list.Empty()) {
+            std::cerr << "Nothing to render in " << args.positional[0] << std::endl;
+            return 1;
+        }
+        int width = std::max(1, (int)std::round(list.GetWidth() * scale));
+        int height = std::max(1, (int)std::round(list.GetHeight() * scale));
+        std::filesystem::path output = args.positional[1];
+        std::string extension = output.extension().string();
+        std::unique_ptr<SVGImageSink> sink;
+        if (extension == ".ppm" or extension == ".pam") sink = std::make_unique<SVGPNMWriter>(output, width, height, extension == ".pam");
+        else sink = std::make_unique<SVGPNGWriter>(output, width, height, options);
+        SVGRasterizer rasterizer;
+        rasterizer.SetSamples(args.GetInt("msaa", 1));
+        rasterizer.SetJitter(args.GetInt("jitter", 0) != 0);
+        if (!list.ReplayBands(rasterizer, *sink, scale, ssaa, bandBytes)) return 1;
+        std::cout << width << "x" << height << " in " << Milliseconds(start) << " ms" << std::endl;
+        return 0;
+    }
+
+    // levels sharing one recording; replaying at up to 2^(n-1) times coarser than recorded stays cheap
+    constexpr int LevelsPerRecording = 3;
+
+    // svg-cli tiles <input.svg> <output-dir> [--zoom MIN-MAX] [--tile SIZE] [--ssaa N] [--cache DIR]
+    // Level z fits the longer canvas side into tile * 2^z pixels; tiles go to <output-dir>/z/x/y.png.
+    int Tiles(const Arguments& args) {
+        if (args.positional.size() != 2) return 2;
+        std::string zoom = args.Get("zoom", "0-3");
+        auto dash = zoom.find('-');
+        int minZoom = std::stoi(zoom.substr(0, dash));
+        int maxZoom = dash == std::string::npos ? minZoom : std::stoi(zoom.substr(dash + 1));
+        int tile = std::max(1, args.GetInt("tile", 256));
+        int ssaa = std::max(1, args.GetInt("ssaa", 1));
+        PNGOptions options = EncodeOptions(args);
+        if (minZoom < 0 or maxZoom < minZoom or maxZoom > 24) {
+            std::cerr << "Invalid zoom range: " << zoom << std::endl;
+            return 2;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        tinyxml2::XMLDocument doc;
+        if (!SVGParser::LoadDocument(args.positional[0], doc)) return 1;
+        auto [x, y] = SVGParser::GetSceneSize(doc);
+        float longest = std::max(x > 0 ? x : 800, y > 0 ? y : 600);
+        auto levelScale = [&](int z) { return tile * std::ldexp(1.0f, z) / longest; };
+        // recorded coordinates reach longest * detail pixels; past 2^22 floats lose the quarter-pixel steps the rasterizer needs
+        if ((double)tile * std::ldexp(1.0, maxZoom) * ssaa > double(1 << 22)) {
+            std::cerr << "Zoom " << maxZoom << " exceeds float precision at tile size " << tile << " and ssaa " << ssaa << std::endl;
+            return 2;
+        }
+
+        // each band of levels gets its own recording, flattened for its deepest level, so shallow levels stay cheap;
+        // all of them come from the one parse above
+        std::vector<int> details;
+        for (int first = minZoom; first <= maxZoom; first += LevelsPerRecording)
+            details.push_back((int)std::ceil(levelScale(std::min(maxZoom, first + LevelsPerRecording - 1)) * ssaa));
+        std::string cache = args.Get("cache", "");
+        std::vector<SVGDisplayList> lists = cache.empty() ? SVGDisplayList::Record(doc, args.positional[0], details)
+                                                          : SVGSceneCache(cache).Load(args.positional[0], details, &doc);
+        if (lists.front().Empty()) {
+            std::cerr << "Nothing to render in " << args.positional[0] << std::endl;
+            return 1;
+        }
+        double recorded = Milliseconds(start);
+
+        // tiles of one flat color (mostly empty margins) are encoded once and the bytes reused
+        std::mutex                                      uniformMutex;
+        std::map<std::uint32_t, std::vector<std::byte>> uniform;
+        std::atomic_int                                 uniformCount = 0, failures = 0;
+        std::filesystem::path root = args.positional[1];
+        std::size_t tiles = 0;
+        for (int first = minZoom, band = 0; first <= maxZoom; first += LevelsPerRecording, band++) {
+            int last = std::min(maxZoom, first + LevelsPerRecording - 1);
+            const SVGDisplayList& list = lists[band];
+
+            struct Job { int z, x, y; };
+            std::vector<Job> jobs;
+            for (int z = first; z <= last; z++) {
+                int columns = (int)std::ceil(list.GetWidth() * levelScale(z) / tile);
+                int rows = (int)std::ceil(list.GetHeight() * levelScale(z) / tile);
+                for (int i = 0; i < columns; i++) {
+                    std::filesystem::create_directories(root / std::to_string(z) / std::to_string(i));
+                    for (int j = 0; j < rows; j++) jobs.push_back({ z, i, j });
+                }
+            }
+            tiles += jobs.size();
+
+            VCX::Engine::ParallelFor(0, (int)jobs.size(), [&](int index) {
+                thread_local SVGRasterizer rasterizer;
+                const Job& job = jobs[index];
+                float scale = levelScale(job.z);
+                Common::ImageRGB big = Common::ImageRGB::Uninitialized({ std::size_t(tile * ssaa), std::size_t(tile * ssaa) });
+                std::size_t drawn = list.Replay(rasterizer, big, scale * ssaa, glm::vec2(job.x, job.y) * (float)tile / scale);
+                Common::ImageRGB image = big;
+                if (ssaa > 1 and drawn > 0) {
+                    image = Common::ImageRGB::Uninitialized({ std::size_t(tile), std::size_t(tile) });
+                    rasterizer.Supersample(image, big, ssaa);
+                } else if (ssaa > 1) image = Common::CreatePureImageRGB(tile, tile, glm::vec3{1.0f});
+
+                auto pixels = image.GetBytes();
+                bool flat = true;
+                for (std::size_t k = 3; k < pixels.size() and flat; k++) flat = pixels[k] == pixels[k % 3];
+                std::filesystem::path file = root / std::to_string(job.z) / std::to_string(job.x) / (std::to_string(job.y) + ".png");
+                bool written;
+                if (flat) {
+                    std::uint32_t color = (std::uint32_t(pixels[0]) << 16) | (std::uint32_t(pixels[1]) << 8) | std::uint32_t(pixels[2]);
+                    std::unique_lock lock(uniformMutex);
+                    auto it = uniform.find(color);
+                    if (it == uniform.end()) it = uniform.emplace(color, SVGExport::EncodePNG(image, options)).first;
+                    lock.unlock();
+                    // entries are never erased, so the bytes stay valid without the lock
+                    written = !it->second.empty() and SVGExport::WriteFile(file, it->second);
+                    uniformCount++;
+                } else {
+                    auto png = SVGExport::EncodePNG(image, options);
+                    written = !png.empty() and SVGExport::WriteFile(file, png);
+                }
+                if (!written) failures++;
+            });
+        }
+
+        std::cout << tiles << " tiles (" << uniformCount << " flat, " << uniform.size() << " encoded) on "
+                  << VCX::Engine::Executor::Instance().Size() + 1 << " threads; recorded in " << recorded
+                  << " ms, total " << Milliseconds(start) << " ms" << std::endl;
+        return failures > 0 ? 1 : 0;
+    }
+
+    // svg-cli icons <input.svg> <output-dir> [--sizes 16,32,48,256] [--ssaa N] [--ico FILE]
+    // Writes <output-dir>/<stem>-<size>x<size>.png per size.
+    int Icons(const Arguments& args) {
+        if (args.positional.size() != 2) return 2;
+        std::vector<int> sizes;
+        std::stringstream list(args.Get("sizes", "16,32,48,256"));
+        for (std::string item; std::getline(list, item, ',');)
+            if (!item.empty()) sizes.push_back(std::stoi(item));
+        int ssaa = std::max(1, args.GetInt("ssaa", 4));
+        PNGOptions options = EncodeOptions(args);
+        if (sizes.empty() or *std::min_element(sizes.begin(), sizes.end()) < 1) {
+            std::cerr << "Invalid icon sizes: " << args.Get("sizes", "") << std::endl;
+            return 2;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        tinyxml2::XMLDocument doc;
+        if (!SVGParser::LoadDocument(args.positional[0], doc)) return 1;
+        // the icon is the root viewBox, centered in a square
+        glm::mat3 userToCanvas;
+        glm::vec4 viewBox = SVGParser::GetViewBox(doc, &userToCanvas);
+        float side = std::max(viewBox.z, viewBox.w);
+        glm::vec4 region(viewBox.x + (viewBox.z - side) * 0.5f, viewBox.y + (viewBox.w - side) * 0.5f, side, side);
+        // each size is flattened just finely enough for its own pixel grid; sizes sharing a detail share a list
+        auto detailOf = [&](int size) { return std::max(1, (int)std::ceil(size * ssaa / (side * userToCanvas[0][0]))); };
+        std::set<int> distinct;
+        for (int size : sizes) distinct.insert(detailOf(size));
+        std::vector<int> details(distinct.begin(), distinct.end());
+        std::vector<SVGDisplayList> lists = SVGDisplayList::Record(doc, args.positional[0], details);
+        if (lists.empty() or lists.front().Empty()) {
+            std::cerr << "Nothing to render in " << args.positional[0] << std::endl;
+            return 1;
+        }
+        double recorded = Milliseconds(start);
+
+        std::filesystem::path root = args.positional[1];
+        std::filesystem::create_directories(root);
+        std::string stem = std::filesystem::path(args.positional[0]).stem().string();
+        std::vector<std::vector<std::byte>> pngs(sizes.size());
+        std::atomic_int failures = 0;
+        VCX::Engine::ParallelFor(0, (int)sizes.size(), [&](int index) {
+            thread_local SVGRasterizer rasterizer;
+            int size = sizes[index];
+            const SVGDisplayList& scene = lists[std::lower_bound(details.begin(), details.end(), detailOf(size)) - details.begin()];
+            Common::ImageRGB big = Common::ImageRGB::Uninitialized({ std::size_t(size * ssaa), std::size_t(size * ssaa) });
+            scene.RenderRegion(rasterizer, big, region);
+            Common::ImageRGB image = Common::ImageRGB::Uninitialized({ std::size_t(size), std::size_t(size) });
+            rasterizer.Supersample(image, big, ssaa);
+            pngs[index] = SVGExport::EncodePNG(image, options);
+            std::string name = stem + "-" + std::to_string(size) + "x" + std::to_string(size) + ".png";
+            if (pngs[index].empty() or !SVGExport::WriteFile(root / name, pngs[index])) failures++;
+        });
+
+        std::string ico = args.Get("ico", "");
+        if (!ico.empty()) {
+            std::vector<std::vector<std::byte>> entries;
+            std::vector<int> entrySizes;
+            for (std::size_t i = 0; i < sizes.size(); i++) {
+                if (sizes[i] > 256) {
+                    std::cerr << "Warning: .ico images are limited to 256 pixels, skipped size:" << sizes[i] << std::endl;
+                    continue;
+                }
+                if (pngs[i].empty()) continue;
+                entries.push_back(pngs[i]);
+                entrySizes.push_back(sizes[i]);
+            }
+            if (!SVGExport::WriteFile(ico, SVGExport::EncodeICO(entries, entrySizes))) failures++;
+        }
+
+        std::cout << sizes.size() << " icons from " << lists.size() << " flattenings; recorded in " << recorded
+                  << " ms, total " << Milliseconds(start) << " ms" << std::endl;
+        return failures > 0 ? 1 : 0;
+    }
+
+    // svg-cli bench-png <input.svg> [--scale S] [--level L] [--filter F] [--runs N]
+    // Renders once, then times stb_image_write against SVGExport on the same pixels at the same settings.
+    int BenchPNG(const Arguments& args) {
+        if (args.positional.size() != 1) return 2;
+        float scale = args.GetFloat("scale", 4.0f);
+        int runs = std::max(1, args.GetInt("runs", 5));
+        PNGOptions options = EncodeOptions(args);
+        SVGDisplayList list = Load(args, args.positional[0], (int)std::ceil(scale));
+        if (list.Empty()) {
+            std::cerr << "Nothing to render in " << args.positional[0] << std::endl;
+            return 1;
+        }
+        int width = std::max(1, (int)std::round(list.GetWidth() * scale));
+        int height = std::max(1, (int)std::round(list.GetHeight() * scale));
+        SVGRasterizer rasterizer;
+        Common::ImageRGB image = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(height) }, true);
+        list.Replay(rasterizer, image, scale);
+
+        auto measure = [&](const char* name, auto&& encode) {
+            double best = 1e30;
+            std::size_t size = 0;
+            for (int i = 0; i < runs; i++) {
+                auto start = std::chrono::steady_clock::now();
+                size = encode();
+                best = std::min(best, Milliseconds(start));
+            }
+            std::cout << name << ": " << best << " ms, " << size << " bytes, "
+                      << width * height * 3 / best / 1000.0 << " MB/s" << std::endl;
+        };
+        std::cout << width << "x" << height << ", level " << options.level << ", best of " << runs << std::endl;
+        stbi_write_png_compression_level = std::clamp(options.level, 0, 9);
+        stbi_write_force_png_filter = options.filter == PNGFilter::Adaptive ? -1 : int(options.filter);
+        measure("stb_image_write", [&]() {
+            std::size_t size = 0;
+            auto count = [](void* context, void*, int bytes) { *static_cast<std::size_t*>(context) += bytes; };
+            stbi_write_png_to_func(count, &size, width, height, 3, image.GetBytes().data(), width * 3);
+            return size;
+        });
+        measure("SVGExport", [&]() { return SVGExport::EncodePNG(image, options).size(); });
+        return 0;
+    }
+
+    // svg-cli bench-schedule <input.svg>... [--scale S] [--ssaa N] [--msaa 2-32] [--jitter 0|1] [--runs N] [--threads N]
+    // Measures each document, then times the scheduler's plan next to fixed alternatives, predicted against measured.
+    int BenchSchedule(const Arguments& args) {
+        if (args.positional.empty()) return 2;
+        float scale = args.GetFloat("scale", 1.0f);
+        int ssaa = std::max(1, args.GetInt("ssaa", 1));
+        int samples = std::max(1, args.GetInt("msaa", 1));
+        bool jitter = args.GetInt("jitter", 0) != 0;
+        int runs = std::max(1, args.GetInt("runs", 3));
+        int threads = args.GetInt("threads", 0);
+        double error = 0;
+        int timed = 0;
+        for (const std::string& input : args.positional) {
+            SVGDisplayList list = Load(args, input, (int)std::ceil(scale * ssaa));
+            if (list.Empty()) {
+                std::cerr << "Warning: nothing to render in " << input << std::endl;
+                continue;
+            }
+            int width = std::max(1, (int)std::round(list.GetWidth() * scale));
+            int height = std::max(1, (int)std::round(list.GetHeight() * scale));
+            auto start = std::chrono::steady_clock::now();
+            SVGComplexity c = SVGScheduler::Measure(list, scale, ssaa, width, height, samples);
+            double measured = Milliseconds(start);
+            SVGRenderPlan chosen = SVGScheduler::Plan(c, threads);
+            std::cout << input << ": " << width << "x" << height << ", " << c.shapes << "/" << c.ops << " ops, "
+                      << c.vertices << " vertices, " << c.edges << " edges, " << (std::size_t)c.edgeRows << " edge rows, overdraw "
+                      << c.overdraw << ", filtered " << (std::size_t)c.filteredArea << " px, edge tiles "
+                      << c.edgeArea / (double(width) * height) * 100 << "%; measured in " << measured << " ms" << std::endl;
+
+            std::vector<SVGRenderPlan> plans { chosen, { .ssaa = ssaa, .samples = chosen.samples } };
+            for (int size : { 128, 256, 512 })
+                plans.push_back({ .strategy = SVGStrategy::Tiled, .regionSize = size, .threads = chosen.threads, .ssaa = ssaa, .samples = chosen.samples });
+            plans.push_back({ .strategy = SVGStrategy::Banded, .regionSize = std::max(1, height / 8), .ssaa = ssaa, .samples = chosen.samples });
+            if (ssaa > 1)
+                plans.push_back({ .strategy = SVGStrategy::Adaptive, .regionSize = SVGScheduler::EdgeTile, .threads = chosen.threads, .ssaa = ssaa, .samples = chosen.samples });
+            for (SVGRenderPlan& plan : plans) plan.jitter = jitter and plan.samples > 1;
+            SVGRasterizer rasterizer;
+            Common::ImageRGB image = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(height) });
+            Common::ImageRGB reference;
+            for (std::size_t i = 0; i < plans.size(); i++) {
+                SVGRenderPlan& plan = plans[i];
+                plan.predictedMs = SVGScheduler::Predict(c, plan);
+                plan.serialMs = chosen.serialMs;
+                double best = 1e30;
+                for (int r = 0; r < runs; r++) {
+                    auto begin = std::chrono::steady_clock::now();
+                    SVGScheduler::Render(list, rasterizer, image, scale, plan);
+                    best = std::min(best, Milliseconds(begin));
+                }
+                error += std::abs(std::log(plan.predictedMs / best));
+                timed++;
+                std::cout << (i == 0 ? "  * " : "    ") << plan.Describe() << "; measured " << best << " ms";
+                if (i == 1) reference = image;
+                if (plan.strategy == SVGStrategy::Adaptive) {
+                    // how far it strays from full SSAA, in 8-bit levels
+                    int worst = 0;
+                    std::size_t off = 0;
+                    for (int y = 0; y < height; y++)
+                        for (int x = 0; x < width; x++) {
+                            int d = 0;
+                            for (int k = 0; k < 3; k++) d = std::max(d, std::abs(int(image.Row(y)[x][k]) - int(reference.Row(y)[x][k])));
+                            worst = std::max(worst, d);
+                            off += d > 2;
+                        }
+                    std::cout << "; max difference " << worst << ", " << off << " pixels off by more than 2";
+                }
+                std::cout << std::endl;
+            }
+        }
+        if (timed > 0) std::cout << "mean |log(predicted / measured)|: " << error / timed << std::endl;
+        return 0;
+    }
+
+    // svg-cli bench-aa <input.svg>... [--scale S] [--runs N]
+    // Error of each antialiasing mode and sample count against 16x16 SSAA, in 8-bit levels. `blurred` compares
+    // both images after a 5x5 binomial blur, which keeps structured aliasing but averages fine noise away,
+    // as the eye does at a normal viewing distance.
+    int BenchAA(const Arguments& args) {
+        if (args.positional.empty()) return 2;
+        float scale = args.GetFloat("scale", 1.0f);
+        int runs = std::max(1, args.GetInt("runs", 3));
+        constexpr int referenceRate = 16;
+        auto blur = [](const Common::ImageRGB& image) {
+            int width = (int)image.GetSizeX(), height = (int)image.GetSizeY();
+            std::vector<glm::vec3> horizontal(std::size_t(width) * height), result(horizontal.size());
+            static constexpr float Weights[5] = { 1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f };
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    for (int k = 0; k < 5; k++)
+                        horizontal[std::size_t(y) * width + x] += Weights[k] * glm::vec3(image.At(std::clamp(x + k - 2, 0, width - 1), y));
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    for (int k = 0; k < 5; k++)
+                        result[std::size_t(y) * width + x] += Weights[k] * horizontal[std::size_t(std::clamp(y + k - 2, 0, height - 1)) * width + x];
+            return result;
+        };
+        for (const std::string& input : args.positional) {
+            // one recording flattened for the reference, so only the sampling differs between rows
+            SVGDisplayList list = Load(args, input, (int)std::ceil(scale * referenceRate));
+            if (list.Empty()) {
+                std::cerr << "Warning: nothing to render in " << input << std::endl;
+                continue;
+            }
+            int width = std::max(1, (int)std::round(list.GetWidth() * scale));
+            int height = std::max(1, (int)std::round(list.GetHeight() * scale));
+            Common::ImageRGB reference = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(height) });
+            Common::ImageRGB image = reference;
+            SVGRasterizer rasterizer;
+            auto begin = std::chrono::steady_clock::now();
+            SVGScheduler::Render(list, rasterizer, reference, scale,
+                SVGScheduler::Plan(SVGScheduler::Measure(list, scale, referenceRate, width, height)));
+            std::cout << input << ": " << width << "x" << height << ", " << referenceRate << "x" << referenceRate
+                      << " SSAA reference in " << Milliseconds(begin) << " ms" << std::endl;
+            std::vector<glm::vec3> referenceBlurred = blur(reference);
+
+            auto measure = [&](const std::string& name, int samples, auto&& render) {
+                double best = 1e30;
+                for (int r = 0; r < runs; r++) {
+                    auto begin = std::chrono::steady_clock::now();
+                    render();
+                    best = std::min(best, Milliseconds(begin));
+                }
+                std::vector<glm::vec3> blurred = blur(image);
+                double sum = 0, sumBlurred = 0;
+                int worst = 0;
+                for (int y = 0; y < height; y++)
+                    for (int x = 0; x < width; x++) {
+                        glm::vec3 d = glm::abs(glm::vec3(image.At(x, y)) - glm::vec3(reference.At(x, y))) * 255.0f;
+                        glm::vec3 e = glm::abs(blurred[std::size_t(y) * width + x] - referenceBlurred[std::size_t(y) * width + x]) * 255.0f;
+                        float m = std::max({ d.x, d.y, d.z });
+                        sum += m;
+                        sumBlurred += std::max({ e.x, e.y, e.z });
+                        worst = std::max(worst, (int)std::round(m));
+                    }
+                double pixels = double(width) * height;
+                std::cout << "    " << name << ", " << samples << " samples: " << best << " ms, mean error " << sum / pixels
+                          << ", blurred " << sumBlurred / pixels << ", max " << worst << std::endl;
+            };
+            for (int rate = 1; rate <= 4; rate++)
+                measure("ssaa " + std::to_string(rate) + "x" + std::to_string(rate), rate * rate, [&]() {
+                    SVGScheduler::Render(list, rasterizer, image, scale, { .ssaa = rate });
+                });
+            for (bool jitter : { false, true })
+                for (int samples = 2; samples <= 32; samples *= 2)
+                    measure(jitter ? "msaa jittered" : "msaa", samples, [&]() {
+                        rasterizer.SetSamples(samples);
+                        rasterizer.SetJitter(jitter);
+                        list.Replay(rasterizer, image, scale);
+                    });
+            rasterizer.SetSamples(1);
+            rasterizer.SetJitter(false);
+        }
+        return 0;
+    }
+
+    // svg-cli bench-edit <input.svg>... [--scale S] [--ssaa N] [--elements N] [--runs N]
+    // Moves up to N elements with ids, one at a time, and compares redrawing the frame against redrawing only
+    // the damage; `max diff` is the largest 8-bit difference between the two results.
+    int BenchEdit(const Arguments& args) {
+        if (args.positional.empty()) return 2;
+        float scale = args.GetFloat("scale", 1.0f);
+        int ssaa = std::max(1, args.GetInt("ssaa", 1));
+        int elements = std::max(1, args.GetInt("elements", 8));
+        int runs = std::max(1, args.GetInt("runs", 3));
+        for (const std::string& input : args.positional) {
+            SVGDisplayList list = Load(args, input, (int)std::ceil(scale * ssaa));
+            int width = std::max(1, (int)std::round(list.GetWidth() * scale));
+            int height = std::max(1, (int)std::round(list.GetHeight() * scale));
+            // ids may repeat; each distinct one is edited once
+            std::vector<std::string> ids;
+            for (auto& element : list.GetElements())
+                if (std::find(ids.begin(), ids.end(), element.id) == ids.end()) ids.push_back(element.id);
+            std::cout << input << ": " << width << "x" << height << ", " << ids.size() << " ids" << std::endl;
+            if (ids.empty()) continue;
+
+            SVGRasterizer rasterizer;
+            Common::ImageRGB frame = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(height) });
+            Common::ImageRGB full = frame, region;
+            SVGScheduler::Render(list, rasterizer, frame, scale, { .ssaa = ssaa });
+            // redraws the damage into `frame`, returning how many pixels that rewrote
+            auto repaint = [&]() {
+                double pixels = 0;
+                for (auto& rect : list.TakeDamage()) {
+                    glm::ivec2 at = list.RenderDamage(rasterizer, region, scale, ssaa, width, height, rect);
+                    for (std::size_t j = 0; j < region.GetSizeY(); j++)
+                        std::copy_n(region.Row(j), region.GetSizeX(), frame.Row(at.y + j) + at.x);
+                    pixels += double(region.GetSizeX()) * region.GetSizeY();
+                }
+                return pixels;
+            };
+            int count = std::min<int>(elements, ids.size());
+            for (int k = 0; k < count; k++) {
+                const std::string& id = ids[std::size_t(k) * ids.size() / count];
+                // a tenth of the canvas diagonally and back on alternate runs; the element is put back afterwards
+                glm::mat3 move(1.0f);
+                move[2] = glm::vec3(glm::vec2(list.GetWidth(), list.GetHeight()) * 0.1f / list.GetUserToCanvas()[0][0], 1.0f);
+                double fullMs = 1e30, damageMs = 1e30, pixels = 0;
+                for (int r = 0; r < runs; r++) {
+                    list.SetTransform(id, r % 2 == 0 ? move : glm::mat3(1.0f));
+                    auto begin = std::chrono::steady_clock::now();
+                    pixels = repaint();
+                    damageMs = std::min(damageMs, Milliseconds(begin));
+                    begin = std::chrono::steady_clock::now();
+                    SVGScheduler::Render(list, rasterizer, full, scale, { .ssaa = ssaa });
+                    fullMs = std::min(fullMs, Milliseconds(begin));
+                }
+                int worst = 0;
+                for (int y = 0; y < height; y++)
+                    for (int x = 0; x < width; x++) {
+                        glm::vec3 d = glm::abs(glm::vec3(frame.At(x, y)) - glm::vec3(full.At(x, y))) * 255.0f;
+                        worst = std::max(worst, (int)std::round(std::max({ d.x, d.y, d.z })));
+                    }
+                std::cout << "    #" << id << ": damage " << 100.0 * pixels / (double(width) * height) << "% of the frame, "
+                          << damageMs << " ms against " << fullMs << " ms, max diff " << worst << std::endl;
+                list.SetTransform(id, glm::mat3(1.0f));
+                repaint();
+            }
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+    Arguments args = ParseArguments(argc, argv);
+    int status = 2;
+    try {
+        if (command == "render") status = Render(args);
+        else if (command == "tiles") status = Tiles(args);
+        else if (command == "icons") status = Icons(args);
+        else if (command == "bench-png") status = BenchPNG(args);
+        else if (command == "bench-schedule") status = BenchSchedule(args);
+        else if (command == "bench-aa") status = BenchAA(args);
+        else if (command == "bench-edit") status = BenchEdit(args);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (status == 2)
+        std::cerr << "usage:\n"
+                     "  svg-cli render <input.svg> <output.png|ppm|pam> [--scale S] [--ssaa N] [--msaa 2-32] [--jitter 0|1] [--band-mb M] [--cache DIR]\n"
+                     "  svg-cli tiles <input.svg> <output-dir> [--zoom MIN-MAX] [--tile SIZE] [--ssaa N] [--cache DIR]\n"
+                     "  svg-cli icons <input.svg> <output-dir> [--sizes 16,32,48,256] [--ssaa N] [--ico FILE]\n"
+                     "  svg-cli bench-png <input.svg> [--scale S] [--runs N]\n"
+                     "  svg-cli bench-schedule <input.svg>... [--scale S] [--ssaa N] [--msaa 2-32] [--jitter 0|1] [--runs N] [--threads N]\n"
+                     "  svg-cli bench-aa <input.svg>... [--scale S] [--runs N]\n"
+                     "  svg-cli bench-edit <input.svg>... [--scale S] [--ssaa N] [--elements N] [--runs N]\n"
+                     "PNG output takes [--level 0-9] [--filter none|sub|up|average|paeth|adaptive]\n";
+    return status;
+}
@@ -1,16 +1,21 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+#include <optional>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include "Labs/Common/ImageRGB.h"
 
 namespace VCX::Labs::GettingStarted {
 
-    enum class ShapeType { Rectangle, Circle, Ellipse, Line, Polyline, Polygon, Path };
+    enum class ShapeType { Rectangle, Circle, Ellipse, Line, Polyline, Polygon, Path, Use, LayerBegin, LayerEnd };
     enum class FillRule { NonZero, EvenOdd };
     enum class StrokeLinecap { Butt, Square, Round };
     enum class StrokeLinejoin { Miter, Round, Bevel };
+    enum class GradientType { Linear, Radial };
+    enum class SpreadMethod { Pad, Reflect, Repeat };
+    enum class TextAnchor { Start, Middle, End };
 
     struct ShapeStyle {
         std::optional<glm::vec4> fill;
@@ -21,9 +26,19 @@ namespace VCX::Labs::GettingStarted {
         std::optional<float> strokeOpacity;
         std::optional<StrokeLinecap> strokeLinecap;
         std::optional<StrokeLinejoin> strokeLinejoin;
+        std::optional<std::vector<float> > strokeDasharray;   // empty for "none"
+        std::optional<float> strokeDashoffset;
+        std::optional<std::string> fillPaint;   // paint server id from fill="url(#id)", empty for a plain color
+        std::optional<std::string> strokePaint;
+        std::optional<float> fontSize;
+        std::optional<std::string> fontFamily;
+        std::optional<TextAnchor> textAnchor;
     };
 
 
+    struct ClipPath;
+    class SVGFont;
+
     struct RenderStyle {
         glm::vec4 fill = {0, 0, 0, 1};
         glm::vec4 stroke = {0, 0, 0, 0};
@@ -31,18 +46,97 @@ namespace VCX::Labs::GettingStarted {
         float totalOpacity = 1.0;
         StrokeLinecap linecap = StrokeLinecap::Butt;
         StrokeLinejoin linejoin = StrokeLinejoin::Miter;
+        std::vector<float> dashArray;
+        float dashOffset = 0.0f;
+        std::string fillPaint;
+        std::string strokePaint;
+        float fontSize = 16.0f;
+        std::string fontFamily;
+        TextAnchor textAnchor = TextAnchor::Start;
+        std::shared_ptr<const ClipPath> clip;   // not a CSS property, but applies to the whole subtree
+    };
+
+    inline RenderStyle InheritStyle(const RenderStyle& parent, const ShapeStyle& local) {
+        RenderStyle result = parent;
+        if (local.fill) result.fill = *local.fill;
+        if (local.stroke) result.stroke = *local.stroke;
+        if (local.strokeWidth) result.strokeWidth = *local.strokeWidth;
+        if (local.opacity) result.totalOpacity *= (*local.opacity);
+        if (local.fillOpacity) {
+            result.fill.a = (*local.fillOpacity);
+        }
+        if (local.strokeOpacity) {
+            result.stroke.a = (*local.strokeOpacity);
+        }
+        if (local.strokeLinecap) {
+            result.linecap = (*local.strokeLinecap);
+        }
+        if (local.strokeLinejoin) {
+            result.linejoin = (*local.strokeLinejoin);
+        }
+        if (local.strokeDasharray) result.dashArray = *local.strokeDasharray;
+        if (local.strokeDashoffset) result.dashOffset = *local.strokeDashoffset;
+        if (local.fillPaint) result.fillPaint = *local.fillPaint;
+        if (local.strokePaint) result.strokePaint = *local.strokePaint;
+        if (local.fontSize) result.fontSize = *local.fontSize;
+        if (local.fontFamily) result.fontFamily = *local.fontFamily;
+        if (local.textAnchor) result.textAnchor = *local.textAnchor;
+        return result;
+    }
+
+    struct Gradient {
+        static constexpr int LutSize = 256;
+
+        GradientType type = GradientType::Linear;
+        SpreadMethod spread = SpreadMethod::Pad;
+        bool objectBoundingBox = true;
+        glm::mat3 transform = glm::mat3(1.0f);   // gradientTransform
+        glm::vec2 p1 = {0, 0}, p2 = {1, 0};       // linear: (x1, y1) -> (x2, y2)
+        glm::vec2 center = {0.5f, 0.5f};          // radial: cx, cy, r, fx, fy
+        glm::vec2 focus = {0.5f, 0.5f};
+        float radius = 0.5f;
+        std::vector<std::pair<float, glm::vec4> > stops;
+        std::vector<glm::vec4> lut;               // stops resampled to LutSize entries over t in [0, 1]
+    };
+
+    // decoded <image> content as a premultiplied RGBA mip chain, levels[0] at full resolution
+    struct Bitmap {
+        struct Level {
+            int width, height;
+            std::vector<glm::u8vec4> pixels;   // Engine::Formats::RGBA8, decoded when sampled
+        };
+        std::vector<Level> levels;
+    };
+
+    // fill/stroke source: a flat color when both gradient and image are null
+    struct Paint {
+        std::shared_ptr<const Gradient> gradient;
+        std::shared_ptr<const Bitmap> image;
+        glm::mat3 inverse = glm::mat3(1.0f);     // canvas -> gradient space, or canvas -> image pixels
     };
 
     struct Shape {
         ShapeType type;
         glm::vec4 fillColor = {0, 0, 0, 1};
         glm::vec4 strokeColor = {0, 0, 0, 0};
+        Paint fillPaint;
+        Paint strokePaint;
+        std::shared_ptr<const ClipPath> clip;
         float strokeWidth = 0;
         StrokeLinecap linecap = StrokeLinecap::Butt;
         StrokeLinejoin linejoin = StrokeLinejoin::Miter;
+        std::vector<float> dashes;   // even-length on/off pattern in canvas units, empty for solid strokes
+        float dashOffset = 0;
+        int element = -1;            // index of the innermost element with an id this op came from, see ElementId
         virtual ~Shape() = default;
     };
 
+    // an element carrying an id attribute; `parent` is the index of the nearest enclosing one, -1 at the top
+    struct ElementId {
+        std::string id;
+        int parent = -1;
+    };
+
     struct Rect : Shape {
         float x, y, width, height;
         Rect() { type = ShapeType::Rectangle; }
@@ -64,4 +158,72 @@ namespace VCX::Labs::GettingStarted {
         FillRule fill_rule = FillRule::NonZero;
         Path() { type = ShapeType::Path; }
     };
-}
\ No newline at end of file
+
+    // canvas-space geometry of a <clipPath> as seen from one referencing user space;
+    // the clip region is the union of `paths` (each filled with its clip-rule) intersected with `parent`
+    struct ClipPath {
+        std::vector<Path*> paths;
+        std::shared_ptr<const ClipPath> parent;
+        int element = -1;   // the element with an id whose subtree introduced this clip, see ElementId
+
+        ClipPath() = default;
+        ClipPath(const ClipPath&) = delete;
+        ClipPath& operator=(const ClipPath&) = delete;
+        ~ClipPath() { for (auto p : paths) delete p; }
+    };
+
+    // A <defs>/<symbol> subtree flattened once, in its own user space scaled by `scale`.
+    // Each entry keeps only the style set inside the definition; the rest comes from the <use> site.
+    struct Definition {
+        struct Entry {
+            Path* path;
+            ShapeStyle style;
+            glm::mat3 transform;   // entry user space -> definition space
+        };
+
+        std::string id;
+        float scale = 1.0f;
+        std::vector<Entry> entries;
+        const SVGFont* font = nullptr;   // set on glyph outlines shared by SVGFont
+        int glyph = -1;
+
+        Definition() = default;
+        Definition(const Definition&) = delete;
+        Definition& operator=(const Definition&) = delete;
+        ~Definition() { for (auto& e : entries) delete e.path; }
+    };
+
+    struct Use : Shape {
+        std::shared_ptr<const Definition> definition;
+        glm::mat3 transform = glm::mat3(1.0f); // definition space -> canvas
+        RenderStyle style;                     // style inherited at the <use> site
+        std::vector<Paint> fillPaints;         // per entry, only filled when some entry uses a paint server
+        std::vector<Paint> strokePaints;
+        Use() { type = ShapeType::Use; }
+    };
+
+    enum class FilterKind { GaussianBlur, Offset, Flood, Merge };
+
+    struct FilterPrimitive {
+        FilterKind kind;
+        std::vector<std::string> in;          // "SourceGraphic", "SourceAlpha", a result name, or "" for the previous result
+        std::string result;
+        glm::vec2 stdDeviation = {0, 0};      // canvas pixels
+        glm::vec2 offset = {0, 0};            // canvas pixels
+        glm::vec4 flood = {0, 0, 0, 1};
+    };
+
+    // a <filter> resolved for one referencing element, in canvas space
+    struct Filter {
+        glm::vec4 region;                     // x0, y0, x1, y1
+        std::vector<FilterPrimitive> primitives;
+    };
+
+    // shapes between a LayerBegin and its LayerEnd are composited as one isolated group with `opacity`,
+    // after running `filter` on them when there is one
+    struct Layer : Shape {
+        float opacity = 1.0f;
+        std::shared_ptr<const Filter> filter;
+        Layer(ShapeType t) { type = t; }
+    };
+}
@@ -0,0 +1,1262 @@
+#include "SVGDisplayList.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include "SVGExport.h"
+#include "SVGFont.h"
+#include "SVGParser.h"
+
+namespace VCX::Labs::GettingStarted {
+
+    SVGDisplayList::SVGDisplayList(SVGDisplayList&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SVGDisplayList& SVGDisplayList::operator=(SVGDisplayList&& other) noexcept {
+        if (this == &other) return *this;
+        for (auto s : _shapes) delete s;
+        _shapes = std::move(other._shapes);
+        other._shapes.clear();
+        _width = other._width;
+        _height = other._height;
+        _detail = other._detail;
+        _userToCanvas = other._userToCanvas;
+        _bounds = std::move(other._bounds);
+        _elements = std::move(other._elements);
+        _transforms = std::move(other._transforms);
+        _hidden = std::move(other._hidden);
+        _damage = std::move(other._damage);
+        return *this;
+    }
+
+    SVGDisplayList::~SVGDisplayList() {
+        for (auto s : _shapes) delete s;
+    }
+
+    SVGDisplayList SVGDisplayList::Record(const std::string& filename, int detail) {
+        tinyxml2::XMLDocument doc;
+        SVGParser::LoadDocument(filename, doc);
+        return std::move(Record(doc, filename, std::span<const int>(&detail, 1))[0]);
+    }
+
+    std::vector<SVGDisplayList> SVGDisplayList::Record(tinyxml2::XMLDocument& doc, const std::string& filename, std::span<const int> details) {
+        std::vector<SVGDisplayList> lists(details.size());
+        auto [x, y] = SVGParser::GetSceneSize(doc);
+        for (std::size_t i = 0; i < details.size(); i++) {
+            SVGDisplayList& list = lists[i];
+            list._detail = std::max(1, details[i]);
+            list._shapes = SVGParser::ParseDocument(doc, filename, list._detail, &list._userToCanvas, &list._elements);
+            // ParseDocument lays the document out on a canvas of detail x (width, height); bring the mapping back to rate 1
+            glm::mat3 unscale(1.0f / list._detail);
+            unscale[2][2] = 1.0f;
+            list._userToCanvas = unscale * list._userToCanvas;
+            list._width = x > 0 ? x : 800;
+            list._height = y > 0 ? y : 600;
+            list.ComputeBounds();
+        }
+        return lists;
+    }
+
+    // recorded-space x0, y0, x1, y1 of one op including strokes; `entries` caches definition extents across calls
+    static glm::vec4 ShapeBounds(const Shape* shape, std::map<const Definition*, std::vector<glm::vec4>>& entries) {
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        auto extent = [](const Path& path) {
+            glm::vec2 lo(inf), hi(-inf);
+            for (auto& subpath : path.sub_paths)
+                for (auto& p : subpath) {
+                    lo = glm::min(lo, p);
+                    hi = glm::max(hi, p);
+                }
+            return glm::vec4(lo.x, lo.y, hi.x, hi.y);
+        };
+        // miter joins reach up to 4 half-widths past the outline
+        glm::vec4 bounds(-inf, -inf, inf, inf);
+        if (shape->type == ShapeType::Path) {
+            bounds = extent(*static_cast<const Path*>(shape));
+            float margin = shape->strokeColor.a > 1e-6 ? shape->strokeWidth * 2.0f : 0.0f;
+            bounds += glm::vec4(-margin, -margin, margin, margin);
+        } else if (shape->type == ShapeType::Use) {
+            auto use = static_cast<const Use*>(shape);
+            auto [it, inserted] = entries.try_emplace(use->definition.get());
+            if (inserted)
+                for (auto& entry : use->definition->entries) it->second.push_back(extent(*entry.path));
+            const glm::mat3& T = use->transform;
+            float linearScale = std::sqrt(std::abs(T[0][0] * T[1][1] - T[1][0] * T[0][1]));
+            glm::vec2 lo(inf), hi(-inf);
+            for (size_t i = 0; i < it->second.size(); i++) {
+                const glm::vec4& b = it->second[i];
+                if (b.x > b.z) continue;
+                auto& entry = use->definition->entries[i];
+                float margin = 2.0f * linearScale * entry.style.strokeWidth.value_or(use->style.strokeWidth)
+                             * std::sqrt(std::abs(glm::determinant(entry.transform)));
+                for (glm::vec2 corner : { glm::vec2(b.x, b.y), glm::vec2(b.z, b.y), glm::vec2(b.x, b.w), glm::vec2(b.z, b.w) }) {
+                    glm::vec2 q = glm::vec2(T * glm::vec3(corner, 1.0f));
+                    lo = glm::min(lo, q - margin);
+                    hi = glm::max(hi, q + margin);
+                }
+            }
+            bounds = glm::vec4(lo.x, lo.y, hi.x, hi.y);
+        }
+        return bounds;
+    }
+
+    void SVGDisplayList::ComputeBounds() {
+        std::map<const Definition*, std::vector<glm::vec4>> entries;
+        _bounds.clear();
+        _bounds.reserve(_shapes.size());
+        for (auto shape : _shapes) _bounds.push_back(ShapeBounds(shape, entries));
+    }
+
+    static bool Overlaps(glm::vec2 lo, glm::vec2 hi, const glm::vec4& rect) {
+        return lo.x <= rect.z and hi.x >= rect.x and lo.y <= rect.w and hi.y >= rect.y;
+    }
+
+    static bool Contains(const glm::vec4& rect, glm::vec2 lo, glm::vec2 hi) {
+        return lo.x >= rect.x and hi.x <= rect.z and lo.y >= rect.y and hi.y <= rect.w;
+    }
+
+    // Sutherland-Hodgman against an axis-aligned rectangle (x0, y0, x1, y1). Parts outside are
+    // folded onto its border, so the winding of every point inside the rectangle is unchanged.
+    static std::vector<glm::vec2> ClipPolygon(const std::vector<glm::vec2>& polygon, const glm::vec4& rect) {
+        std::vector<glm::vec2> input = polygon, output;
+        for (int side = 0; side < 4 and !input.empty(); side++) {
+            int axis = side % 2;
+            float bound = rect[side];
+            auto inside = [&](glm::vec2 p) { return side < 2 ? p[axis] >= bound : p[axis] <= bound; };
+            output.clear();
+            for (size_t i = 0; i < input.size(); i++) {
+                glm::vec2 a = input[i], b = input[(i + 1) % input.size()];
+                bool ia = inside(a), ib = inside(b);
+                if (ia) output.push_back(a);
+                if (ia != ib) output.push_back(a + (b - a) * ((bound - a[axis]) / (b[axis] - a[axis])));
+            }
+            input.swap(output);
+        }
+        return input;
+    }
+
+    // splits a polyline into runs of segments that touch `rect`; the dropped segments, and the caps
+    // and joins at the new ends, lie outside it
+    static void SplitRuns(const std::vector<glm::vec2>& points, const glm::vec4& rect, std::vector<std::vector<glm::vec2>>& runs) {
+        bool open = false;
+        for (size_t i = 0; i + 1 < points.size(); i++) {
+            glm::vec2 a = points[i], b = points[i + 1];
+            if (!Overlaps(glm::min(a, b), glm::max(a, b), rect)) {
+                open = false;
+                continue;
+            }
+            if (!open) runs.push_back({ a });
+            runs.back().push_back(b);
+            open = true;
+        }
+    }
+
+    // Copies recorded shapes into a target where recorded point p lands on p * scale + offset.
+    // Ops whose pixels cannot reach `view` are dropped, and paths crossing it are trimmed to a
+    // margin around it before scan conversion.
+    struct Retarget {
+        float     scale;
+        glm::vec2 offset;
+        glm::mat3 view, inverseView;
+        std::map<const ClipPath*, std::shared_ptr<const ClipPath>> clips;
+        std::map<const Filter*, std::shared_ptr<const Filter>>     filters;
+        glm::vec4 target;            // x0, y0, x1, y1 of the image
+        float     reach = 0.0f;      // how far open filters spread content, infinite to disable culling
+
+        Retarget(float s, glm::vec2 t, glm::vec4 image): scale(s), offset(t), view(s), target(image) {
+            view[2] = glm::vec3(t, 1.0f);
+            inverseView = glm::inverse(view);
+        }
+
+        glm::vec4 Padded(float margin) const {
+            return target + glm::vec4(-margin, -margin, margin, margin);
+        }
+
+        glm::vec2 Point(glm::vec2 p) const { return p * scale + offset; }
+
+        Paint Move(const Paint& paint) const {
+            Paint result = paint;
+            result.inverse = paint.inverse * inverseView;
+            return result;
+        }
+
+        void Base(Shape& shape) {
+            shape.fillPaint = Move(shape.fillPaint);
+            shape.strokePaint = Move(shape.strokePaint);
+            shape.strokeWidth *= scale;
+            for (float& dash : shape.dashes) dash *= scale;
+            shape.dashOffset *= scale;
+            if (shape.clip) shape.clip = Clip(shape.clip.get());
+        }
+
+        Path* MovePath(const Path& path) {
+            Path* result = new Path(path);
+            Base(*result);
+            for (auto& subpath : result->sub_paths)
+                for (auto& p : subpath) p = Point(p);
+            return result;
+        }
+
+        std::shared_ptr<const ClipPath> Clip(const ClipPath* clip) {
+            auto it = clips.find(clip);
+            if (it != clips.end()) return it->second;
+            auto result = std::make_shared<ClipPath>();
+            // clip masks are built at image size, so the regions only matter inside it
+            glm::vec4 rect = Padded(2.0f);
+            for (auto path : clip->paths) {
+                Path* moved = MovePath(*path);
+                for (auto& subpath : moved->sub_paths) subpath = ClipPolygon(subpath, rect);
+                result->paths.push_back(moved);
+            }
+            if (clip->parent) result->parent = Clip(clip->parent.get());
+            return clips[clip] = result;
+        }
+
+        std::shared_ptr<const Filter> MoveFilter(const Filter* filter) {
+            auto it = filters.find(filter);
+            if (it != filters.end()) return it->second;
+            auto result = std::make_shared<Filter>(*filter);
+            glm::vec2 lo = Point({ filter->region.x, filter->region.y }), hi = Point({ filter->region.z, filter->region.w });
+            result->region = { lo.x, lo.y, hi.x, hi.y };
+            for (auto& primitive : result->primitives) {
+                primitive.stdDeviation *= scale;
+                primitive.offset *= scale;
+            }
+            return filters[filter] = result;
+        }
+
+        // appends the retargeted op, split into a fill and a stroke op when the two are trimmed differently
+        void EmitPath(Path* path, std::vector<Shape*>& out) {
+            bool stroked = path->strokeColor.a > 1e-6 and path->strokeWidth > 1e-6;
+            // miter joins reach up to 4 half-widths past the outline
+            glm::vec4 rect = Padded((stroked ? path->strokeWidth * 2.0f : 0.0f) + 2.0f + reach);
+            glm::vec2 lo(1e30f), hi(-1e30f);
+            for (auto& subpath : path->sub_paths)
+                for (auto& p : subpath) {
+                    lo = glm::min(lo, p);
+                    hi = glm::max(hi, p);
+                }
+            if (std::isinf(reach) or Contains(rect, lo, hi)) {
+                out.push_back(path);
+                return;
+            }
+            if (!Overlaps(lo, hi, rect)) {
+                delete path;
+                return;
+            }
+
+            Path* fill = nullptr;
+            if (path->fillColor.a >= 1e-6) {
+                fill = stroked ? new Path(*path) : path;
+                fill->strokeWidth = 0;
+                for (auto& subpath : fill->sub_paths) subpath = ClipPolygon(subpath, rect);
+                out.push_back(fill);
+            }
+            if (!stroked) {
+                if (!fill) delete path;
+                return;
+            }
+            path->fillColor.a = 0;
+            // dash phases depend on the whole outline; the dash walk culls off-image dashes itself
+            if (path->dashes.empty()) {
+                std::vector<std::vector<glm::vec2>> runs;
+                for (auto& subpath : path->sub_paths) {
+                    if (subpath.size() == 1) runs.push_back(subpath);
+                    else SplitRuns(subpath, rect, runs);
+                }
+                path->sub_paths = std::move(runs);
+            }
+            out.push_back(path);
+        }
+
+        // `bounds` is the op's recorded-space extent from ComputeBounds
+        void operator()(const Shape* shape, const glm::vec4& bounds, std::vector<Shape*>& out) {
+            if (!std::isinf(reach) and !Overlaps(Point({ bounds.x, bounds.y }), Point({ bounds.z, bounds.w }), Padded(2.0f + reach))) return;
+            Shape* result = nullptr;
+            if (shape->type == ShapeType::Path) {
+                EmitPath(MovePath(*static_cast<const Path*>(shape)), out);
+                return;
+            }
+            if (shape->type == ShapeType::Use) {
+                Use* use = new Use(*static_cast<const Use*>(shape));
+                use->transform = view * use->transform;
+                for (auto& paint : use->fillPaints) paint = Move(paint);
+                for (auto& paint : use->strokePaints) paint = Move(paint);
+                result = use;
+            } else if (shape->type == ShapeType::LayerBegin or shape->type == ShapeType::LayerEnd) {
+                Layer* layer = new Layer(*static_cast<const Layer*>(shape));
+                if (layer->filter) layer->filter = MoveFilter(layer->filter.get());
+                result = layer;
+            } else if (shape->type == ShapeType::Rectangle) {
+                Rect* rect = new Rect(*static_cast<const Rect*>(shape));
+                glm::vec2 p = Point({ rect->x, rect->y });
+                rect->x = p.x, rect->y = p.y, rect->width *= scale, rect->height *= scale;
+                result = rect;
+            } else if (shape->type == ShapeType::Circle) {
+                Circle* circle = new Circle(*static_cast<const Circle*>(shape));
+                glm::vec2 c = Point({ circle->cx, circle->cy });
+                circle->cx = c.x, circle->cy = c.y, circle->r *= scale;
+                result = circle;
+            } else if (shape->type == ShapeType::Ellipse) {
+                Ellipse* ellipse = new Ellipse(*static_cast<const Ellipse*>(shape));
+                glm::vec2 c = Point({ ellipse->cx, ellipse->cy });
+                ellipse->cx = c.x, ellipse->cy = c.y, ellipse->rx *= scale, ellipse->ry *= scale;
+                result = ellipse;
+            }
+            if (result) {
+                Base(*result);
+                out.push_back(result);
+            }
+        }
+    };
+
+    // how far blur and offset primitives move content, in the filter's pixels
+    static float FilterReach(const Filter& filter) {
+        float reach = 0.0f;
+        for (auto& primitive : filter.primitives)
+            reach += 3.0f * std::max(primitive.stdDeviation.x, primitive.stdDeviation.y)
+                   + std::max(std::abs(primitive.offset.x), std::abs(primitive.offset.y));
+        return reach;
+    }
+
+    std::size_t SVGDisplayList::Replay(SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, glm::vec2 origin) const {
+        float s = scale / _detail;
+        glm::vec2 t = -origin * scale;
+        if (s == 1.0f and t == glm::vec2(0.0f)) {
+            if (_hidden.empty()) {
+                rasterizer.Rasterize(image, _shapes);
+                return _shapes.size();
+            }
+            std::vector<Shape*> visible;
+            for (size_t i = 0; i < _shapes.size(); i++)
+                if (!_hidden[i]) visible.push_back(_shapes[i]);
+            rasterizer.Rasterize(image, visible);
+            return visible.size();
+        }
+
+        // layer surfaces end at the image border, so content a filter pulls in from outside needs a guard band;
+        // filter output is clamped to its region, so only regions that reach the image count, and only as far as they overhang it
+        int width = image.GetSizeX(), height = image.GetSizeY();
+        float guard = 0.0f;
+        std::vector<float> reaches;
+        for (size_t i = 0; i < _shapes.size(); i++) {
+            const Shape* shape = _shapes[i];
+            if (shape->type == ShapeType::LayerBegin) {
+                auto& filter = static_cast<const Layer*>(shape)->filter;
+                reaches.push_back((reaches.empty() ? 0.0f : reaches.back()) + (filter ? FilterReach(*filter) * s : 0.0f));
+                if (!filter or (!_hidden.empty() and _hidden[i])) continue;
+                float reach = reaches.back();
+                glm::vec2 lo = glm::vec2(filter->region.x, filter->region.y) * s + t;
+                glm::vec2 hi = glm::vec2(filter->region.z, filter->region.w) * s + t;
+                if (hi.x + reach <= 0 or hi.y + reach <= 0 or lo.x - reach >= width or lo.y - reach >= height) continue;
+                float overhang = std::max({ 0.0f, -lo.x, -lo.y, hi.x - width, hi.y - height });
+                guard = std::max(guard, std::min(reach, overhang));
+            } else if (shape->type == ShapeType::LayerEnd and !reaches.empty()) reaches.pop_back();
+        }
+        int band = (int)std::ceil(guard);
+        Common::ImageRGB padded;
+        if (band > 0) padded = Common::ImageRGB::Uninitialized({ std::size_t(width + 2 * band), std::size_t(height + 2 * band) }, true);
+        Common::ImageRGB& target = band > 0 ? padded : image;
+
+        Retarget retarget(s, t + glm::vec2(band), { (float)band, (float)band, (float)(band + width), (float)(band + height) });
+        std::vector<Shape*> shapes;
+        shapes.reserve(_shapes.size());
+        // filters spread their children, so culling inside a filtered layer widens by the filter's reach
+        reaches.clear();
+        for (size_t i = 0; i < _shapes.size(); i++) {
+            if (!_hidden.empty() and _hidden[i]) continue;
+            const Shape* shape = _shapes[i];
+            size_t first = shapes.size();
+            retarget(shape, _bounds[i], shapes);
+            if (shape->type == ShapeType::LayerBegin) {
+                reaches.push_back(retarget.reach);
+                if (auto& filter = static_cast<Layer*>(shapes[first])->filter) {
+                    retarget.reach += FilterReach(*filter);
+                    for (auto& primitive : filter->primitives)
+                        if (primitive.kind == FilterKind::Flood) retarget.reach = std::numeric_limits<float>::infinity();
+                }
+            } else if (shape->type == ShapeType::LayerEnd and !reaches.empty()) {
+                retarget.reach = reaches.back();
+                reaches.pop_back();
+            }
+        }
+        // layer markers never cull, so anything else that survived is an actual drawing op
+        std::size_t drawn = std::count_if(shapes.begin(), shapes.end(), [](const Shape* shape) {
+            return shape->type != ShapeType::LayerBegin and shape->type != ShapeType::LayerEnd;
+        });
+        // the padded target starts `band` pixels above and left of the image, and so must its noise
+        glm::ivec2 noiseOrigin = rasterizer.GetJitterOrigin();
+        bool shifted = band > 0 and rasterizer.GetJitter();
+        if (shifted) rasterizer.SetJitter(true, noiseOrigin - band);
+        rasterizer.Rasterize(target, shapes);
+        if (shifted) rasterizer.SetJitter(true, noiseOrigin);
+        for (auto shape : shapes) delete shape;
+        if (band > 0)
+            for (int y = 0; y < height; y++) std::copy_n(padded.Row(y + band) + band, width, image.Row(y));
+        return drawn;
+    }
+
+    bool SVGDisplayList::ReplayBands(SVGRasterizer& rasterizer, SVGImageSink& sink, float scale, int ssaa, std::size_t bandBytes) const {
+        int width = sink.GetWidth(), height = sink.GetHeight();
+        ssaa = std::max(1, ssaa);
+        // the supersampled band dominates: width * ssaa pixels for each of rows * ssaa lines
+        std::size_t rowBytes = std::size_t(width) * ssaa * ssaa * 3;
+        int rows = (int)std::clamp<std::size_t>(bandBytes / std::max<std::size_t>(rowBytes, 1), 1, std::max(height, 1));
+        Common::ImageRGB big, band;
+        for (int y = 0; y < height; y += rows) {
+            int count = std::min(rows, height - y);
+            big = Common::ImageRGB::Uninitialized({ std::size_t(width * ssaa), std::size_t(count * ssaa) }, true);
+            Replay(rasterizer, big, scale * ssaa, glm::vec2(0.0f, y / scale));
+            if (ssaa > 1) {
+                band = Common::ImageRGB::Uninitialized({ std::size_t(width), std::size_t(count) });
+                rasterizer.Supersample(band, big, ssaa);
+            }
+            if (!sink.WriteRows((ssaa > 1 ? band : big).GetBytes(), count)) return false;
+        }
+        return sink.Finish();
+    }
+
+    glm::ivec2 SVGDisplayList::RenderDamage(SVGRasterizer& rasterizer, Common::ImageRGB& region, float scale, int ssaa, int width, int height, const glm::vec4& rect) const {
+        ssaa = std::max(1, ssaa);
+        // a pixel of margin for the antialiased fringe
+        int x0 = std::max(0, (int)std::floor(rect.x * scale) - 1), y0 = std::max(0, (int)std::floor(rect.y * scale) - 1);
+        int x1 = std::min(width, (int)std::ceil(rect.z * scale) + 1), y1 = std::min(height, (int)std::ceil(rect.w * scale) + 1);
+        region = Common::ImageRGB();
+        if (x0 >= x1 or y0 >= y1) return { 0, 0 };
+        std::size_t w = x1 - x0, h = y1 - y0;
+        Common::ImageRGB big = Common::ImageRGB::Uninitialized({ w * ssaa, h * ssaa });
+        // the jitter pattern stays anchored to the frame
+        rasterizer.SetJitter(rasterizer.GetJitter(), glm::ivec2(x0, y0) * ssaa);
+        Replay(rasterizer, big, scale * ssaa, glm::vec2(x0, y0) / scale);
+        if (ssaa == 1) region = std::move(big);
+        else {
+            region = Common::ImageRGB::Uninitialized({ w, h });
+            rasterizer.Supersample(region, big, ssaa);
+        }
+        return { x0, y0 };
+    }
+
+    std::size_t SVGDisplayList::RenderRegion(SVGRasterizer& rasterizer, Common::ImageRGB& image, const glm::vec4& region) const {
+        if (region.z <= 0 or region.w <= 0) return 0;
+        float pixelsPerUnit = std::min(image.GetSizeX() / region.z, image.GetSizeY() / region.w);
+        // the root viewBox mapping is a uniform scale plus an offset
+        float canvasPerUnit = _userToCanvas[0][0];
+        glm::vec2 origin = glm::vec2(_userToCanvas * glm::vec3(region.x, region.y, 1.0f));
+        return Replay(rasterizer, image, pixelsPerUnit / canvasPerUnit, origin);
+    }
+
+    // Moves recorded ops by an affine map D in recorded space, carrying paints, clips and filters along.
+    // The parser records only paths, instances and layer markers, so the primitive shapes are left alone.
+    // Clips go with the element that introduced them: `owner` names its Reposition, or null when the clip stays put.
+    struct Reposition {
+        glm::mat3 D, inverse;
+        float     scale;   // how D scales lengths such as stroke widths and blur radii
+        std::function<Reposition*(int)> owner;
+        std::map<const ClipPath*, std::shared_ptr<const ClipPath>> clips;
+        std::map<const Filter*, std::shared_ptr<const Filter>>     filters;
+
+        explicit Reposition(const glm::mat3& d): D(d), inverse(glm::inverse(d)), scale(std::sqrt(std::abs(glm::determinant(d)))) {}
+
+        glm::vec2 Point(glm::vec2 p) const { return glm::vec2(D * glm::vec3(p, 1.0f)); }
+
+        void Move(Paint& paint) const { paint.inverse = paint.inverse * inverse; }
+
+        void MovePath(Path& path) {
+            for (auto& subpath : path.sub_paths)
+                for (auto& p : subpath) p = Point(p);
+            path.strokeWidth *= scale;
+            for (float& dash : path.dashes) dash *= scale;
+            path.dashOffset *= scale;
+            Move(path.fillPaint);
+            Move(path.strokePaint);
+            if (path.clip) path.clip = Clip(path.clip);
+        }
+
+        std::shared_ptr<const ClipPath> Clip(const std::shared_ptr<const ClipPath>& clip) {
+            Reposition* by = owner ? owner(clip->element) : this;
+            if (!by) return clip;
+            if (by != this) return by->Clip(clip);
+            auto it = clips.find(clip.get());
+            if (it != clips.end()) return it->second;
+            auto result = std::make_shared<ClipPath>();
+            result->element = clip->element;
+            for (auto path : clip->paths) {
+                Path* moved = new Path(*path);
+                MovePath(*moved);
+                result->paths.push_back(moved);
+            }
+            if (clip->parent) result->parent = Clip(clip->parent);
+            return clips[clip.get()] = result;
+        }
+
+        std::shared_ptr<const Filter> MoveFilter(const Filter* filter) {
+            auto it = filters.find(filter);
+            if (it != filters.end()) return it->second;
+            auto result = std::make_shared<Filter>(*filter);
+            const glm::vec4& r = filter->region;
+            glm::vec2 lo(std::numeric_limits<float>::infinity()), hi(-std::numeric_limits<float>::infinity());
+            for (glm::vec2 corner : { glm::vec2(r.x, r.y), glm::vec2(r.z, r.y), glm::vec2(r.x, r.w), glm::vec2(r.z, r.w) }) {
+                lo = glm::min(lo, Point(corner));
+                hi = glm::max(hi, Point(corner));
+            }
+            result->region = { lo.x, lo.y, hi.x, hi.y };
+            for (auto& primitive : result->primitives) {
+                primitive.stdDeviation *= scale;
+                primitive.offset = glm::vec2(D * glm::vec3(primitive.offset, 0.0f));
+            }
+            return filters[filter] = result;
+        }
+
+        void operator()(Shape* shape) {
+            if (shape->type == ShapeType::Path) MovePath(*static_cast<Path*>(shape));
+            else if (shape->type == ShapeType::Use) {
+                Use* use = static_cast<Use*>(shape);
+                use->transform = D * use->transform;
+                for (auto& paint : use->fillPaints) Move(paint);
+                for (auto& paint : use->strokePaints) Move(paint);
+                if (use->clip) use->clip = Clip(use->clip);
+            } else if (shape->type == ShapeType::LayerBegin or shape->type == ShapeType::LayerEnd) {
+                Layer* layer = static_cast<Layer*>(shape);
+                if (layer->filter) layer->filter = MoveFilter(layer->filter.get());
+                if (layer->clip) layer->clip = Clip(layer->clip);
+            }
+        }
+    };
+
+    bool SVGDisplayList::Select(const std::string& id, std::vector<std::size_t>& ops, std::vector<bool>* elements) const {
+        // the parser lists parents before their children
+        std::vector<bool> match(_elements.size());
+        bool found = false;
+        for (size_t e = 0; e < _elements.size(); e++) {
+            int parent = _elements[e].parent;
+            match[e] = _elements[e].id == id or (parent >= 0 and match[parent]);
+            found = found or match[e];
+        }
+        ops.clear();
+        for (size_t i = 0; found and i < _shapes.size(); i++) {
+            int element = _shapes[i]->element;
+            if (element >= 0 and element < (int)match.size() and match[element]) ops.push_back(i);
+        }
+        if (elements) *elements = std::move(match);
+        return found;
+    }
+
+    std::vector<glm::vec4> SVGDisplayList::Extents(const std::vector<std::size_t>& ops) const {
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        // how far the filters enclosing each op spread it
+        std::vector<float> reach(_shapes.size()), stack;
+        float current = 0.0f;
+        for (size_t i = 0; i < _shapes.size(); i++) {
+            reach[i] = current;
+            const Shape* shape = _shapes[i];
+            if (shape->type == ShapeType::LayerBegin) {
+                stack.push_back(current);
+                if (auto& filter = static_cast<const Layer*>(shape)->filter) current += FilterReach(*filter);
+            } else if (shape->type == ShapeType::LayerEnd and !stack.empty()) {
+                current = stack.back();
+                stack.pop_back();
+            }
+        }
+        std::vector<glm::vec4> extents;
+        extents.reserve(ops.size());
+        for (auto i : ops) {
+            const Shape* shape = _shapes[i];
+            glm::vec4 extent(inf, inf, -inf, -inf);
+            if (!_hidden.empty() and _hidden[i]) {
+            } else if (shape->type == ShapeType::LayerBegin) {
+                // a filter may paint anywhere in its region, a flood even where its children do not
+                if (auto& filter = static_cast<const Layer*>(shape)->filter) extent = filter->region;
+            } else if (shape->type != ShapeType::LayerEnd) extent = _bounds[i];
+            extents.push_back(extent + glm::vec4(-reach[i], -reach[i], reach[i], reach[i]));
+        }
+        return extents;
+    }
+
+    void SVGDisplayList::Invalidate(const std::vector<std::size_t>& ops, const std::vector<glm::vec4>& before) {
+        std::map<const Definition*, std::vector<glm::vec4>> entries;
+        for (auto i : ops) _bounds[i] = ShapeBounds(_shapes[i], entries);
+        for (auto& rect : before) AddDamage(rect);
+        for (auto& rect : Extents(ops)) AddDamage(rect);
+    }
+
+    void SVGDisplayList::AddDamage(glm::vec4 rect) {
+        // also drops unbounded and NaN rectangles, which no partial update can cover anyway
+        if (!(rect.x <= rect.z and rect.y <= rect.w) or std::isinf(rect.x) or std::isinf(rect.y) or std::isinf(rect.z) or std::isinf(rect.w)) return;
+        // absorb every rectangle the new one overlaps, rescanning as it grows
+        for (size_t i = 0; i < _damage.size();) {
+            const glm::vec4& other = _damage[i];
+            if (!Overlaps({ rect.x, rect.y }, { rect.z, rect.w }, other)) {
+                i++;
+                continue;
+            }
+            rect = { std::min(rect.x, other.x), std::min(rect.y, other.y), std::max(rect.z, other.z), std::max(rect.w, other.w) };
+            _damage.erase(_damage.begin() + i);
+            i = 0;
+        }
+        _damage.push_back(rect);
+    }
+
+    std::vector<glm::vec4> SVGDisplayList::TakeDamage() {
+        std::vector<glm::vec4> damage = std::move(_damage);
+        _damage.clear();
+        for (auto& rect : damage) rect /= (float)_detail;
+        return damage;
+    }
+
+    bool SVGDisplayList::SetFill(const std::string& id, const glm::vec4& color) {
+        std::vector<std::size_t> ops;
+        if (!Select(id, ops)) return false;
+        auto before = Extents(ops);
+        for (auto i : ops) {
+            Shape* shape = _shapes[i];
+            if (shape->type == ShapeType::Path) {
+                shape->fillColor = color;
+                shape->fillPaint = Paint();
+            } else if (shape->type == ShapeType::Use) {
+                Use* use = static_cast<Use*>(shape);
+                use->style.fill = color;
+                use->fillPaints.clear();
+            }
+        }
+        Invalidate(ops, before);
+        return true;
+    }
+
+    bool SVGDisplayList::SetStroke(const std::string& id, const glm::vec4& color) {
+        std::vector<std::size_t> ops;
+        if (!Select(id, ops)) return false;
+        auto before = Extents(ops);
+        for (auto i : ops) {
+            Shape* shape = _shapes[i];
+            if (shape->type == ShapeType::Path) {
+                shape->strokeColor = color;
+                shape->strokePaint = Paint();
+            } else if (shape->type == ShapeType::Use) {
+                Use* use = static_cast<Use*>(shape);
+                use->style.stroke = color;
+                use->strokePaints.clear();
+            }
+        }
+        Invalidate(ops, before);
+        return true;
+    }
+
+    bool SVGDisplayList::SetTransform(const std::string& id, const glm::mat3& transform) {
+        std::vector<std::size_t> ops;
+        std::vector<bool>        selected;
+        if (!Select(id, ops, &selected)) return false;
+        if (_transforms.empty()) _transforms.assign(_elements.size(), glm::mat3(1.0f));
+        // each element moves by its own transform after those of its descendants
+        auto combined = [&] {
+            std::vector<glm::mat3> result(_elements.size());
+            for (size_t e = 0; e < _elements.size(); e++) {
+                int parent = _elements[e].parent;
+                result[e] = parent >= 0 ? result[parent] * _transforms[e] : _transforms[e];
+            }
+            return result;
+        };
+        auto old = combined();
+        for (size_t e = 0; e < _elements.size(); e++)
+            if (_elements[e].id == id) _transforms[e] = transform;
+        auto now = combined();
+
+        auto before = Extents(ops);
+        glm::mat3 canvas((float)_detail);
+        canvas[2][2] = 1.0f;
+        canvas = canvas * _userToCanvas;
+        glm::mat3 toUser = glm::inverse(canvas);
+        // ops of one element move together, so their shared clips and filters are cloned once;
+        // clips introduced outside the edited subtree stay shared and in place
+        std::map<int, Reposition> moves;
+        std::function<Reposition*(int)> reposition = [&](int element) -> Reposition* {
+            if (element < 0 or element >= (int)selected.size() or !selected[element]) return nullptr;
+            auto it = moves.find(element);
+            if (it == moves.end()) {
+                it = moves.emplace(element, Reposition(canvas * now[element] * glm::inverse(old[element]) * toUser)).first;
+                it->second.owner = reposition;
+            }
+            return &it->second;
+        };
+        for (auto i : ops) (*reposition(_shapes[i]->element))(_shapes[i]);
+        Invalidate(ops, before);
+        return true;
+    }
+
+    bool SVGDisplayList::SetVisible(const std::string& id, bool visible) {
+        std::vector<std::size_t> ops;
+        if (!Select(id, ops)) return false;
+        if (_hidden.empty()) _hidden.assign(_shapes.size(), false);
+        // whichever way it goes, the damage is the visible side of the change
+        auto before = Extents(ops);
+        for (auto i : ops) _hidden[i] = !visible;
+        Invalidate(ops, before);
+        return true;
+    }
+
+    static constexpr std::uint32_t Magic = 0x44475653;   // "SVGD"
+
+    struct Writer {
+        std::vector<std::byte> bytes;
+
+        template <typename T>
+        void Put(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto p = reinterpret_cast<const std::byte*>(&value);
+            bytes.insert(bytes.end(), p, p + sizeof(T));
+        }
+
+        template <typename T>
+        void PutArray(const std::vector<T>& values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Put((std::uint32_t)values.size());
+            auto p = reinterpret_cast<const std::byte*>(values.data());
+            bytes.insert(bytes.end(), p, p + values.size() * sizeof(T));
+        }
+
+        void PutString(const std::string& value) {
+            Put((std::uint32_t)value.size());
+            auto p = reinterpret_cast<const std::byte*>(value.data());
+            bytes.insert(bytes.end(), p, p + value.size());
+        }
+
+        template <typename T>
+        void PutOptional(const std::optional<T>& value) {
+            Put((std::uint8_t)value.has_value());
+            if (value) Put(*value);
+        }
+    };
+
+    // every read is bounds-checked; the first failure sticks and later reads return zeros
+    struct Reader {
+        std::span<const std::byte> bytes;
+        std::size_t                pos = 0;
+        bool                       ok = true;
+
+        template <typename T>
+        T Get() {
+            T value{};
+            if (!ok or bytes.size() - pos < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, bytes.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        // element counts are checked against the bytes left, so a corrupt count cannot over-allocate
+        std::uint32_t GetCount(std::size_t elementSize) {
+            auto count = Get<std::uint32_t>();
+            if (ok and count > (bytes.size() - pos) / std::max<std::size_t>(elementSize, 1)) ok = false;
+            return ok ? count : 0;
+        }
+
+        template <typename T>
+        std::vector<T> GetArray() {
+            std::vector<T> values(GetCount(sizeof(T)));
+            if (!values.empty()) {
+                std::memcpy(values.data(), bytes.data() + pos, values.size() * sizeof(T));
+                pos += values.size() * sizeof(T);
+            }
+            return values;
+        }
+
+        std::string GetString() {
+            std::string value(GetCount(1), '\0');
+            if (!value.empty()) {
+                std::memcpy(value.data(), bytes.data() + pos, value.size());
+                pos += value.size();
+            }
+            return value;
+        }
+
+        template <typename T>
+        std::optional<T> GetOptional() {
+            if (Get<std::uint8_t>()) return Get<T>();
+            return std::nullopt;
+        }
+
+        // -1 for none, otherwise must address an already decoded table entry
+        int GetIndex(std::size_t size) {
+            auto index = Get<std::int32_t>();
+            if (index < -1 or index >= (std::int64_t)size) ok = false;
+            return ok ? index : -1;
+        }
+    };
+
+    // Shared objects go to per-kind sections the first time they are referenced; the output lists the
+    // sections so that everything an entry refers to is decoded before it.
+    struct Encoder {
+        Writer gradients, bitmaps, filters, clips, definitions, shapes;
+        std::map<const void*, int> gradientIds, bitmapIds, filterIds, clipIds, definitionIds;
+
+        static int Find(std::map<const void*, int>& ids, const void* key, bool& added) {
+            auto [it, inserted] = ids.try_emplace(key, (int)ids.size());
+            added = inserted;
+            return it->second;
+        }
+
+        int GradientId(const Gradient* gradient) {
+            if (!gradient) return -1;
+            bool added;
+            int id = Find(gradientIds, gradient, added);
+            if (!added) return id;
+            Writer& w = gradients;
+            w.Put((std::uint8_t)gradient->type);
+            w.Put((std::uint8_t)gradient->spread);
+            w.Put((std::uint8_t)gradient->objectBoundingBox);
+            w.Put(gradient->transform);
+            w.Put(gradient->p1);
+            w.Put(gradient->p2);
+            w.Put(gradient->center);
+            w.Put(gradient->focus);
+            w.Put(gradient->radius);
+            w.Put((std::uint32_t)gradient->stops.size());
+            for (auto& [offset, color] : gradient->stops) {
+                w.Put(offset);
+                w.Put(color);
+            }
+            w.PutArray(gradient->lut);
+            return id;
+        }
+
+        int BitmapId(const Bitmap* bitmap) {
+            if (!bitmap) return -1;
+            bool added;
+            int id = Find(bitmapIds, bitmap, added);
+            if (!added) return id;
+            bitmaps.Put((std::uint32_t)bitmap->levels.size());
+            for (auto& level : bitmap->levels) {
+                bitmaps.Put(level.width);
+                bitmaps.Put(level.height);
+                bitmaps.PutArray(level.pixels);
+            }
+            return id;
+        }
+
+        int FilterId(const Filter* filter) {
+            if (!filter) return -1;
+            bool added;
+            int id = Find(filterIds, filter, added);
+            if (!added) return id;
+            filters.Put(filter->region);
+            filters.Put((std::uint32_t)filter->primitives.size());
+            for (auto& primitive : filter->primitives) {
+                filters.Put((std::uint8_t)primitive.kind);
+                filters.Put((std::uint32_t)primitive.in.size());
+                for (auto& name : primitive.in) filters.PutString(name);
+                filters.PutString(primitive.result);
+                filters.Put(primitive.stdDeviation);
+                filters.Put(primitive.offset);
+                filters.Put(primitive.flood);
+            }
+            return id;
+        }
+
+        void PutPaint(Writer& w, const Paint& paint) {
+            w.Put((std::int32_t)GradientId(paint.gradient.get()));
+            w.Put((std::int32_t)BitmapId(paint.image.get()));
+            w.Put(paint.inverse);
+        }
+
+        // paint server ids and fonts are resolved at record time, so only the numeric style survives
+        static void PutStyle(Writer& w, const ShapeStyle& style) {
+            w.PutOptional(style.fill);
+            w.PutOptional(style.stroke);
+            w.PutOptional(style.strokeWidth);
+            w.PutOptional(style.opacity);
+            w.PutOptional(style.fillOpacity);
+            w.PutOptional(style.strokeOpacity);
+            w.PutOptional(style.strokeLinecap);
+            w.PutOptional(style.strokeLinejoin);
+            w.Put((std::uint8_t)style.strokeDasharray.has_value());
+            if (style.strokeDasharray) w.PutArray(*style.strokeDasharray);
+            w.PutOptional(style.strokeDashoffset);
+        }
+
+        int DefinitionId(const Definition* definition) {
+            bool added;
+            int id = Find(definitionIds, definition, added);
+            if (!added) return id;
+            // entries may reference gradients; those land in an earlier section
+            Writer w;
+            w.PutString(definition->font ? definition->font->GetName() : std::string());
+            w.Put((std::int32_t)definition->glyph);
+            w.Put(definition->scale);
+            w.Put((std::uint32_t)definition->entries.size());
+            for (auto& entry : definition->entries) {
+                PutShape(w, entry.path);
+                PutStyle(w, entry.style);
+                w.Put(entry.transform);
+            }
+            definitions.bytes.insert(definitions.bytes.end(), w.bytes.begin(), w.bytes.end());
+            return id;
+        }
+
+        int ClipId(const ClipPath* clip) {
+            if (!clip) return -1;
+            auto it = clipIds.find(clip);
+            if (it != clipIds.end()) return it->second;
+            // parents first, so every parent index points backwards
+            int parent = ClipId(clip->parent.get());
+            Writer w;
+            w.Put((std::int32_t)parent);
+            w.Put((std::int32_t)clip->element);
+            w.Put((std::uint32_t)clip->paths.size());
+            for (auto path : clip->paths) PutShape(w, path);
+            int id = (int)clipIds.size();
+            clipIds[clip] = id;
+            clips.bytes.insert(clips.bytes.end(), w.bytes.begin(), w.bytes.end());
+            return id;
+        }
+
+        void PutShape(Writer& w, const Shape* shape) {
+            w.Put((std::uint8_t)shape->type);
+            w.Put(shape->fillColor);
+            w.Put(shape->strokeColor);
+            PutPaint(w, shape->fillPaint);
+            PutPaint(w, shape->strokePaint);
+            w.Put((std::int32_t)ClipId(shape->clip.get()));
+            w.Put(shape->strokeWidth);
+            w.Put((std::uint8_t)shape->linecap);
+            w.Put((std::uint8_t)shape->linejoin);
+            w.PutArray(shape->dashes);
+            w.Put(shape->dashOffset);
+            if (shape->type == ShapeType::Path) {
+                auto path = static_cast<const Path*>(shape);
+                w.Put((std::uint8_t)path->fill_rule);
+                w.Put((std::uint32_t)path->sub_paths.size());
+                for (auto& subpath : path->sub_paths) w.PutArray(subpath);
+            } else if (shape->type == ShapeType::Use) {
+                auto use = static_cast<const Use*>(shape);
+                w.Put((std::int32_t)DefinitionId(use->definition.get()));
+                w.Put(use->transform);
+                w.Put(use->style.fill);
+                w.Put(use->style.stroke);
+                w.Put(use->style.strokeWidth);
+                w.Put(use->style.totalOpacity);
+                w.Put((std::uint8_t)use->style.linecap);
+                w.Put((std::uint8_t)use->style.linejoin);
+                w.PutArray(use->style.dashArray);
+                w.Put(use->style.dashOffset);
+                w.Put((std::uint32_t)use->fillPaints.size());
+                for (auto& paint : use->fillPaints) PutPaint(w, paint);
+                w.Put((std::uint32_t)use->strokePaints.size());
+                for (auto& paint : use->strokePaints) PutPaint(w, paint);
+            } else if (shape->type == ShapeType::LayerBegin or shape->type == ShapeType::LayerEnd) {
+                auto layer = static_cast<const Layer*>(shape);
+                w.Put(layer->opacity);
+                w.Put((std::int32_t)FilterId(layer->filter.get()));
+            } else if (shape->type == ShapeType::Rectangle) {
+                auto rect = static_cast<const Rect*>(shape);
+                w.Put(glm::vec4(rect->x, rect->y, rect->width, rect->height));
+            } else if (shape->type == ShapeType::Circle) {
+                auto circle = static_cast<const Circle*>(shape);
+                w.Put(glm::vec3(circle->cx, circle->cy, circle->r));
+            } else if (shape->type == ShapeType::Ellipse) {
+                auto ellipse = static_cast<const Ellipse*>(shape);
+                w.Put(glm::vec4(ellipse->cx, ellipse->cy, ellipse->rx, ellipse->ry));
+            }
+        }
+    };
+
+    std::vector<std::byte> SVGDisplayList::Serialize() const {
+        Encoder encoder;
+        std::size_t count = 0;
+        // hidden ops are left out; the element tags follow each op
+        for (size_t i = 0; i < _shapes.size(); i++) {
+            if (!_hidden.empty() and _hidden[i]) continue;
+            encoder.PutShape(encoder.shapes, _shapes[i]);
+            encoder.shapes.Put((std::int32_t)_shapes[i]->element);
+            count++;
+        }
+
+        Writer out;
+        out.Put(Magic);
+        out.Put(Version);
+        out.Put((std::int32_t)_width);
+        out.Put((std::int32_t)_height);
+        out.Put((std::int32_t)_detail);
+        out.Put(_userToCanvas);
+        out.Put((std::uint32_t)_elements.size());
+        for (auto& element : _elements) {
+            out.PutString(element.id);
+            out.Put((std::int32_t)element.parent);
+        }
+        auto section = [&](std::size_t count, const Writer& w) {
+            out.Put((std::uint32_t)count);
+            out.bytes.insert(out.bytes.end(), w.bytes.begin(), w.bytes.end());
+        };
+        section(encoder.gradientIds.size(), encoder.gradients);
+        section(encoder.bitmapIds.size(), encoder.bitmaps);
+        section(encoder.filterIds.size(), encoder.filters);
+        section(encoder.clipIds.size(), encoder.clips);
+        section(encoder.definitionIds.size(), encoder.definitions);
+        section(count, encoder.shapes);
+        return out.bytes;
+    }
+
+    struct Decoder {
+        Reader r;
+        std::vector<std::shared_ptr<const Gradient>>   gradients;
+        std::vector<std::shared_ptr<const Bitmap>>     bitmaps;
+        std::vector<std::shared_ptr<const Filter>>     filters;
+        std::vector<std::shared_ptr<const Definition>> definitions;
+        std::vector<std::shared_ptr<const ClipPath>>   clips;
+        std::size_t                                    elements = 0;
+
+        explicit Decoder(std::span<const std::byte> data): r { data } {}
+
+        std::shared_ptr<const Gradient> GetGradient() {
+            auto gradient = std::make_shared<Gradient>();
+            gradient->type = (GradientType)r.Get<std::uint8_t>();
+            gradient->spread = (SpreadMethod)r.Get<std::uint8_t>();
+            gradient->objectBoundingBox = r.Get<std::uint8_t>() != 0;
+            gradient->transform = r.Get<glm::mat3>();
+            gradient->p1 = r.Get<glm::vec2>();
+            gradient->p2 = r.Get<glm::vec2>();
+            gradient->center = r.Get<glm::vec2>();
+            gradient->focus = r.Get<glm::vec2>();
+            gradient->radius = r.Get<float>();
+            gradient->stops.resize(r.GetCount(sizeof(float) + sizeof(glm::vec4)));
+            for (auto& stop : gradient->stops) {
+                stop.first = r.Get<float>();
+                stop.second = r.Get<glm::vec4>();
+            }
+            gradient->lut = r.GetArray<glm::vec4>();
+            if (gradient->lut.size() != Gradient::LutSize) r.ok = false;
+            return gradient;
+        }
+
+        std::shared_ptr<const Bitmap> GetBitmap() {
+            auto bitmap = std::make_shared<Bitmap>();
+            bitmap->levels.resize(r.GetCount(3 * sizeof(std::int32_t)));
+            for (auto& level : bitmap->levels) {
+                level.width = r.Get<std::int32_t>();
+                level.height = r.Get<std::int32_t>();
+                level.pixels = r.GetArray<glm::u8vec4>();
+                if (level.width <= 0 or level.height <= 0 or level.pixels.size() != (std::size_t)level.width * level.height) r.ok = false;
+            }
+            if (bitmap->levels.empty()) r.ok = false;
+            return bitmap;
+        }
+
+        std::shared_ptr<const Filter> GetFilter() {
+            auto filter = std::make_shared<Filter>();
+            filter->region = r.Get<glm::vec4>();
+            filter->primitives.resize(r.GetCount(1));
+            for (auto& primitive : filter->primitives) {
+                primitive.kind = (FilterKind)r.Get<std::uint8_t>();
+                primitive.in.resize(r.GetCount(sizeof(std::uint32_t)));
+                for (auto& name : primitive.in) name = r.GetString();
+                primitive.result = r.GetString();
+                primitive.stdDeviation = r.Get<glm::vec2>();
+                primitive.offset = r.Get<glm::vec2>();
+                primitive.flood = r.Get<glm::vec4>();
+                // the rasterizer reads in[0] of single-input primitives
+                if (primitive.kind != FilterKind::Merge and primitive.kind != FilterKind::Flood and primitive.in.empty()) r.ok = false;
+            }
+            return filter;
+        }
+
+        Paint GetPaint() {
+            Paint paint;
+            int gradient = r.GetIndex(gradients.size());
+            int image = r.GetIndex(bitmaps.size());
+            if (gradient >= 0) paint.gradient = gradients[gradient];
+            if (image >= 0) paint.image = bitmaps[image];
+            paint.inverse = r.Get<glm::mat3>();
+            return paint;
+        }
+
+        ShapeStyle GetStyle() {
+            ShapeStyle style;
+            style.fill = r.GetOptional<glm::vec4>();
+            style.stroke = r.GetOptional<glm::vec4>();
+            style.strokeWidth = r.GetOptional<float>();
+            style.opacity = r.GetOptional<float>();
+            style.fillOpacity = r.GetOptional<float>();
+            style.strokeOpacity = r.GetOptional<float>();
+            style.strokeLinecap = r.GetOptional<StrokeLinecap>();
+            style.strokeLinejoin = r.GetOptional<StrokeLinejoin>();
+            if (r.Get<std::uint8_t>()) style.strokeDasharray = r.GetArray<float>();
+            style.strokeDashoffset = r.GetOptional<float>();
+            return style;
+        }
+
+        std::shared_ptr<const Definition> GetDefinition() {
+            std::string font = r.GetString();
+            int glyph = r.Get<std::int32_t>();
+            auto definition = std::make_shared<Definition>();
+            definition->scale = r.Get<float>();
+            auto count = r.GetCount(1);
+            for (std::uint32_t i = 0; i < count and r.ok; i++) {
+                Shape* shape = GetShape();
+                if (!shape) break;
+                if (shape->type != ShapeType::Path) {
+                    delete shape;
+                    r.ok = false;
+                    break;
+                }
+                ShapeStyle style = GetStyle();
+                definition->entries.push_back({ static_cast<Path*>(shape), style, r.Get<glm::mat3>() });
+            }
+            // glyph outlines go back to the font's shared copy, so rasterizers keep their glyph caches
+            if (!font.empty() and r.ok)
+                if (const SVGFont* face = SVGFont::Find(font))
+                    if (auto outline = face->GetOutline(glyph)) return outline;
+            return definition;
+        }
+
+        std::shared_ptr<const ClipPath> GetClip() {
+            auto clip = std::make_shared<ClipPath>();
+            int parent = r.GetIndex(clips.size());
+            if (parent >= 0) clip->parent = clips[parent];
+            clip->element = r.GetIndex(elements);
+            auto count = r.GetCount(1);
+            for (std::uint32_t i = 0; i < count and r.ok; i++) {
+                Shape* shape = GetShape();
+                if (!shape) break;
+                if (shape->type != ShapeType::Path) {
+                    delete shape;
+                    r.ok = false;
+                    break;
+                }
+                clip->paths.push_back(static_cast<Path*>(shape));
+            }
+            return clip;
+        }
+
+        // nullptr once the stream is bad
+        Shape* GetShape() {
+            auto type = r.Get<std::uint8_t>();
+            if (type > (std::uint8_t)ShapeType::LayerEnd) r.ok = false;
+            if (!r.ok) return nullptr;
+
+            Shape* shape = nullptr;
+            switch ((ShapeType)type) {
+            case ShapeType::Rectangle: shape = new Rect(); break;
+            case ShapeType::Circle: shape = new Circle(); break;
+            case ShapeType::Ellipse: shape = new Ellipse(); break;
+            case ShapeType::Use: shape = new Use(); break;
+            case ShapeType::LayerBegin:
+            case ShapeType::LayerEnd: shape = new Layer((ShapeType)type); break;
+            default: shape = new Path(); break;   // Line, Polyline, Polygon and Path are all recorded as paths
+            }
+            shape->fillColor = r.Get<glm::vec4>();
+            shape->strokeColor = r.Get<glm::vec4>();
+            shape->fillPaint = GetPaint();
+            shape->strokePaint = GetPaint();
+            int clip = r.GetIndex(clips.size());
+            if (clip >= 0) shape->clip = clips[clip];
+            shape->strokeWidth = r.Get<float>();
+            shape->linecap = (StrokeLinecap)r.Get<std::uint8_t>();
+            shape->linejoin = (StrokeLinejoin)r.Get<std::uint8_t>();
+            shape->dashes = r.GetArray<float>();
+            shape->dashOffset = r.Get<float>();
+
+            if (shape->type == ShapeType::Path) {
+                auto path = static_cast<Path*>(shape);
+                path->fill_rule = (FillRule)r.Get<std::uint8_t>();
+                path->sub_paths.resize(r.GetCount(sizeof(std::uint32_t)));
+                for (auto& subpath : path->sub_paths) subpath = r.GetArray<glm::vec2>();
+            } else if (shape->type == ShapeType::Use) {
+                auto use = static_cast<Use*>(shape);
+                int definition = r.GetIndex(definitions.size());
+                if (definition < 0) r.ok = false;
+                else use->definition = definitions[definition];
+                use->transform = r.Get<glm::mat3>();
+                use->style.fill = r.Get<glm::vec4>();
+                use->style.stroke = r.Get<glm::vec4>();
+                use->style.strokeWidth = r.Get<float>();
+                use->style.totalOpacity = r.Get<float>();
+                use->style.linecap = (StrokeLinecap)r.Get<std::uint8_t>();
+                use->style.linejoin = (StrokeLinejoin)r.Get<std::uint8_t>();
+                use->style.dashArray = r.GetArray<float>();
+                use->style.dashOffset = r.Get<float>();
+                use->fillPaints.resize(r.GetCount(2 * sizeof(std::int32_t)));
+                for (auto& paint : use->fillPaints) paint = GetPaint();
+                use->strokePaints.resize(r.GetCount(2 * sizeof(std::int32_t)));
+                for (auto& paint : use->strokePaints) paint = GetPaint();
+                // StyleInstance indexes the paint arrays per entry
+                if (use->definition) {
+                    std::size_t entries = use->definition->entries.size();
+                    if ((!use->fillPaints.empty() and use->fillPaints.size() != entries)
+                        or (!use->strokePaints.empty() and use->strokePaints.size() != entries)) r.ok = false;
+                }
+            } else if (shape->type == ShapeType::LayerBegin or shape->type == ShapeType::LayerEnd) {
+                auto layer = static_cast<Layer*>(shape);
+                layer->opacity = r.Get<float>();
+                int filter = r.GetIndex(filters.size());
+                if (filter >= 0) layer->filter = filters[filter];
+            } else if (shape->type == ShapeType::Rectangle) {
+                auto rect = static_cast<Rect*>(shape);
+                glm::vec4 v = r.Get<glm::vec4>();
+                rect->x = v.x, rect->y = v.y, rect->width = v.z, rect->height = v.w;
+            } else if (shape->type == ShapeType::Circle) {
+                auto circle = static_cast<Circle*>(shape);
+                glm::vec3 v = r.Get<glm::vec3>();
+                circle->cx = v.x, circle->cy = v.y, circle->r = v.z;
+            } else if (shape->type == ShapeType::Ellipse) {
+                auto ellipse = static_cast<Ellipse*>(shape);
+                glm::vec4 v = r.Get<glm::vec4>();
+                ellipse->cx = v.x, ellipse->cy = v.y, ellipse->rx = v.z, ellipse->ry = v.w;
+            }
+            if (!r.ok) {
+                delete shape;
+                return nullptr;
+            }
+            return shape;
+        }
+
+        template <typename T, typename F>
+        void Table(std::vector<T>& table, F&& get) {
+            auto count = r.GetCount(1);
+            for (std::uint32_t i = 0; i < count and r.ok; i++) table.push_back(get());
+        }
+    };
+
+    bool SVGDisplayList::Deserialize(std::span<const std::byte> bytes, SVGDisplayList& list) {
+        list = SVGDisplayList();
+        Decoder d(bytes);
+        if (d.r.Get<std::uint32_t>() != Magic or d.r.Get<std::uint32_t>() != Version) return false;
+        int width = d.r.Get<std::int32_t>();
+        int height = d.r.Get<std::int32_t>();
+        int detail = d.r.Get<std::int32_t>();
+        glm::mat3 userToCanvas = d.r.Get<glm::mat3>();
+        // parents come first, so a parent index must point backwards
+        auto elements = d.r.GetCount(sizeof(std::uint32_t) + sizeof(std::int32_t));
+        for (std::uint32_t i = 0; i < elements and d.r.ok; i++) {
+            std::string id = d.r.GetString();
+            list._elements.push_back({ std::move(id), d.r.GetIndex(i) });
+        }
+        d.elements = list._elements.size();
+        d.Table(d.gradients, [&] { return d.GetGradient(); });
+        d.Table(d.bitmaps, [&] { return d.GetBitmap(); });
+        d.Table(d.filters, [&] { return d.GetFilter(); });
+        d.Table(d.clips, [&] { return d.GetClip(); });
+        d.Table(d.definitions, [&] { return d.GetDefinition(); });
+        auto count = d.r.GetCount(1);
+        for (std::uint32_t i = 0; i < count and d.r.ok; i++)
+            if (Shape* shape = d.GetShape()) {
+                shape->element = d.r.GetIndex(list._elements.size());
+                list._shapes.push_back(shape);
+            }
+        if (!d.r.ok or d.r.pos != bytes.size() or detail < 1) {
+            list = SVGDisplayList();
+            return false;
+        }
+        list._width = width;
+        list._height = height;
+        list._detail = detail;
+        list._userToCanvas = userToCanvas;
+        list.ComputeBounds();
+        return true;
+    }
+}
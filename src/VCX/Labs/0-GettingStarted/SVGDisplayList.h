@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "SVGData.h"
+#include "SVGRasterizer.h"
+#include <tinyxml2.h>
+#include "Labs/Common/ImageRGB.h"
+
+namespace VCX::Labs::GettingStarted {
+    class SVGImageSink;
+
+    // A document recorded once into the flat op list the rasterizer consumes: every shape already carries
+    // its resolved paint, canvas transform, shared geometry (Use), clip and layer markers, so replaying
+    // needs no XML or string lookups. Shapes are stored at `detail` x the scene's canvas resolution;
+    // replays at or below that density show no flattening facets.
+    class SVGDisplayList {
+    public:
+        static constexpr std::uint32_t Version = 5;
+
+        SVGDisplayList() = default;
+        SVGDisplayList(SVGDisplayList&& other) noexcept;
+        SVGDisplayList& operator=(SVGDisplayList&& other) noexcept;
+        SVGDisplayList(const SVGDisplayList&) = delete;
+        SVGDisplayList& operator=(const SVGDisplayList&) = delete;
+        ~SVGDisplayList();
+
+        static SVGDisplayList Record(const std::string& filename, int detail);
+        // flattens one loaded document (see SVGParser::LoadDocument) at each of `details`; one list per entry, in order
+        static std::vector<SVGDisplayList> Record(tinyxml2::XMLDocument& doc, const std::string& filename, std::span<const int> details);
+
+        bool Empty() const { return _shapes.empty(); }
+        int GetWidth() const { return _width; }     // canvas size at sample rate 1
+        int GetHeight() const { return _height; }
+        int GetDetail() const { return _detail; }
+        const glm::mat3& GetUserToCanvas() const { return _userToCanvas; }   // root user space -> canvas at sample rate 1
+        const std::vector<Shape*>& GetShapes() const { return _shapes; }
+        // per op, parallel to GetShapes(): recorded-space x0, y0, x1, y1 including strokes; unbounded for layer markers
+        const std::vector<glm::vec4>& GetBounds() const { return _bounds; }
+
+        // Editing by element id: each call changes every op the element produced, its descendants' included,
+        // and returns false when no element has that id. Edits last until the document is recorded again.
+        const std::vector<ElementId>& GetElements() const { return _elements; }
+        // flat fill and stroke colors, replacing any paint server; alpha is final, except that <use> instances
+        // still apply their opacity and keep colors set inside the referenced definition
+        bool SetFill(const std::string& id, const glm::vec4& color);
+        bool SetStroke(const std::string& id, const glm::vec4& color);
+        // `transform` in root user space, applied on top of the document's own transforms and those set on
+        // enclosing elements; identity restores the recorded geometry
+        bool SetTransform(const std::string& id, const glm::mat3& transform);
+        bool SetVisible(const std::string& id, bool visible);
+        // canvas x0, y0, x1, y1 at sample rate 1 of everything the edits since the last call changed, old and new
+        // positions alike; overlapping rectangles are merged
+        std::vector<glm::vec4> TakeDamage();
+
+        // draws the canvas scaled by `scale` (e.g. the sample rate) with `origin` (canvas units) at image pixel (0, 0);
+        // ops that cannot reach the image are skipped and paths crossing its border are trimmed before scan conversion.
+        // Returns how many drawing ops reached the image; with none it is left plain white.
+        std::size_t Replay(SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, glm::vec2 origin = { 0, 0 }) const;
+        // renders the output pixels the canvas rectangle `rect` (x0, y0, x1, y1, e.g. from TakeDamage) touches in a
+        // `width` x `height` frame at `scale`, padded by a pixel and drawn at `ssaa` x, into `region`; only ops that
+        // reach it are replayed. Returns the region's top-left pixel in the frame; `region` is empty when `rect` misses it
+        glm::ivec2 RenderDamage(SVGRasterizer& rasterizer, Common::ImageRGB& region, float scale, int ssaa, int width, int height, const glm::vec4& rect) const;
+        // renders the canvas at `scale` into `sink` (sized in output pixels) one band of rows at a time, each band
+        // drawn at `ssaa` x and supersampled down; memory follows `bandBytes`, not the output size. Calls Finish().
+        bool ReplayBands(SVGRasterizer& rasterizer, SVGImageSink& sink, float scale, int ssaa = 1, std::size_t bandBytes = std::size_t(64) << 20) const;
+        // draws the root user-space rectangle `region` (x, y, width, height) scaled uniformly to fit `image`,
+        // anchored at its top-left corner; cost follows what is visible in the region, not the document size
+        std::size_t RenderRegion(SVGRasterizer& rasterizer, Common::ImageRGB& image, const glm::vec4& region) const;
+
+        // self-contained native-endian image of the list; shared gradients, bitmaps, definitions,
+        // clips and filters are written once and referenced by index
+        std::vector<std::byte> Serialize() const;
+        // false on a foreign, truncated or outdated buffer; `list` is left empty then
+        static bool Deserialize(std::span<const std::byte> bytes, SVGDisplayList& list);
+
+    private:
+        std::vector<Shape*> _shapes;
+        int                 _width = 0, _height = 0;
+        int                 _detail = 1;
+        glm::mat3           _userToCanvas = glm::mat3(1.0f);
+        std::vector<glm::vec4> _bounds;   // per shape: recorded-space x0, y0, x1, y1 including strokes; layer markers are unbounded
+        std::vector<ElementId> _elements;
+        std::vector<glm::mat3> _transforms;   // per element: SetTransform's, empty until the first call
+        std::vector<bool>      _hidden;       // per shape, empty until the first SetVisible
+        std::vector<glm::vec4> _damage;       // recorded space
+
+        void ComputeBounds();
+        // the ops of every element with `id` and of its descendants, in order, and optionally which elements those are;
+        // false when there is no such element
+        bool Select(const std::string& id, std::vector<std::size_t>& ops, std::vector<bool>* elements = nullptr) const;
+        // recorded-space rectangles `ops` can paint, widened by the filters around them; empty for hidden ops
+        std::vector<glm::vec4> Extents(const std::vector<std::size_t>& ops) const;
+        // re-bounds `ops` after an edit and damages what they covered `before` and cover now
+        void Invalidate(const std::vector<std::size_t>& ops, const std::vector<glm::vec4>& before);
+        void AddDamage(glm::vec4 rect);
+    };
+}
@@ -0,0 +1,336 @@
+#include "SVGExport.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <zlib.h>
+#include "Engine/Parallel.hpp"
+
+namespace VCX::Labs::GettingStarted {
+
+    static constexpr int BytesPerPixel = 3;
+
+    static int PaethPredictor(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb and pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+    // writes the filter type byte and `length` residuals; `prior` is the unfiltered row above (zeros for the first)
+    static void FilterRow(PNGFilter filter, const std::uint8_t* row, const std::uint8_t* prior, std::size_t length, std::uint8_t* out) {
+        constexpr std::size_t n = BytesPerPixel;
+        *out++ = std::uint8_t(filter);
+        std::size_t head = std::min(length, n);
+        switch (filter) {
+        case PNGFilter::None:
+            std::memcpy(out, row, length);
+            break;
+        case PNGFilter::Sub:
+            std::memcpy(out, row, head);
+            for (std::size_t i = n; i < length; i++) out[i] = row[i] - row[i - n];
+            break;
+        case PNGFilter::Up:
+            for (std::size_t i = 0; i < length; i++) out[i] = row[i] - prior[i];
+            break;
+        case PNGFilter::Average:
+            for (std::size_t i = 0; i < head; i++) out[i] = row[i] - (prior[i] >> 1);
+            for (std::size_t i = n; i < length; i++) out[i] = row[i] - ((row[i - n] + prior[i]) >> 1);
+            break;
+        case PNGFilter::Paeth:
+            for (std::size_t i = 0; i < head; i++) out[i] = row[i] - prior[i];
+            for (std::size_t i = n; i < length; i++) out[i] = row[i] - PaethPredictor(row[i - n], prior[i], prior[i - n]);
+            break;
+        default: break;
+        }
+    }
+
+    static void FilterRow(const PNGOptions& options, const std::uint8_t* row, const std::uint8_t* prior, std::size_t length, std::uint8_t* out, std::vector<std::uint8_t>& scratch) {
+        if (options.filter != PNGFilter::Adaptive) {
+            FilterRow(options.filter, row, prior, length, out);
+            return;
+        }
+        // same heuristic as libpng and stb: least sum of residuals taken as signed bytes
+        std::uint64_t best = UINT64_MAX;
+        scratch.resize(length + 1);
+        for (PNGFilter filter : { PNGFilter::None, PNGFilter::Sub, PNGFilter::Up, PNGFilter::Average, PNGFilter::Paeth }) {
+            FilterRow(filter, row, prior, length, scratch.data());
+            std::uint64_t cost = 0;
+            for (std::size_t i = 1; i <= length; i++) cost += std::abs(int(std::int8_t(scratch[i])));
+            if (cost < best) {
+                best = cost;
+                std::memcpy(out, scratch.data(), length + 1);
+            }
+        }
+    }
+
+    static void PutChunk(std::vector<std::byte>& png, const char* type, const std::byte* data, std::size_t size) {
+        auto put32 = [&](std::uint32_t value) {
+            for (int shift = 24; shift >= 0; shift -= 8) png.push_back(std::byte((value >> shift) & 0xff));
+        };
+        put32(std::uint32_t(size));
+        std::size_t start = png.size();
+        png.insert(png.end(), reinterpret_cast<const std::byte*>(type), reinterpret_cast<const std::byte*>(type) + 4);
+        png.insert(png.end(), data, data + size);
+        put32(std::uint32_t(crc32(0, reinterpret_cast<const Bytef*>(png.data() + start), uInt(size + 4))));
+    }
+
+    // signature and IHDR of an 8-bit truecolor image
+    static void PutHeader(std::vector<std::byte>& png, int width, int height) {
+        const std::uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        png.insert(png.end(), reinterpret_cast<const std::byte*>(signature), reinterpret_cast<const std::byte*>(signature) + 8);
+        std::byte header[13] {};
+        for (int i = 0; i < 4; i++) {
+            header[i] = std::byte((width >> (24 - 8 * i)) & 0xff);
+            header[4 + i] = std::byte((height >> (24 - 8 * i)) & 0xff);
+        }
+        header[8] = std::byte(8);    // bit depth
+        header[9] = std::byte(2);    // truecolor
+        PutChunk(png, "IHDR", header, sizeof(header));
+    }
+
+    std::vector<std::byte> SVGExport::EncodePNG(const Common::ImageRGB& image, const PNGOptions& options) {
+        return EncodePNG(image.GetBytes(), int(image.GetSizeX()), int(image.GetSizeY()), options);
+    }
+
+    std::vector<std::byte> SVGExport::EncodePNG(std::span<const std::byte> rgb, int width, int height, const PNGOptions& options) {
+        // PNG has no empty images, and zero stripes would leave the stream without a final block
+        if (width <= 0 or height <= 0) {
+            std::cerr << "Warning: cannot encode an empty image as PNG" << std::endl;
+            return {};
+        }
+        int level = std::clamp(options.level, 0, 9);
+        std::size_t rowBytes = std::size_t(width) * BytesPerPixel;
+        std::size_t lineBytes = rowBytes + 1;
+        // stripes of about 256 KiB keep every worker busy while the window reset costs next to nothing
+        int stripeRows = std::max(1, int((std::size_t(1) << 18) / lineBytes));
+        int stripes = (height + stripeRows - 1) / stripeRows;
+        auto pixels = reinterpret_cast<const std::uint8_t*>(rgb.data());
+
+        std::vector<std::uint8_t> filtered(lineBytes * height);
+        std::vector<std::uint8_t> zeros(rowBytes, 0);
+        Engine::ParallelFor(0, stripes, [&](int stripe) {
+            std::vector<std::uint8_t> scratch;
+            int last = std::min(height, (stripe + 1) * stripeRows);
+            for (int y = stripe * stripeRows; y < last; y++)
+                FilterRow(options, pixels + y * rowBytes, y > 0 ? pixels + (y - 1) * rowBytes : zeros.data(), rowBytes, filtered.data() + y * lineBytes, scratch);
+        });
+
+        std::vector<std::vector<std::byte>> streams(stripes);
+        std::vector<uLong>                  checksums(stripes);
+        std::atomic_bool                    failed = false;
+        Engine::ParallelFor(0, stripes, [&](int stripe) {
+            std::size_t begin = std::size_t(stripe) * stripeRows * lineBytes;
+            std::size_t end = std::min(filtered.size(), begin + std::size_t(stripeRows) * lineBytes);
+            bool final = stripe == stripes - 1;
+            z_stream z {};
+            if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                failed = true;
+                return;
+            }
+            // the previous window lets matches cross the stripe boundary as in a serial stream
+            std::size_t window = std::min<std::size_t>(begin, 32768);
+            bool ok = window == 0 or deflateSetDictionary(&z, filtered.data() + begin - window, uInt(window)) == Z_OK;
+            auto& out = streams[stripe];
+            out.resize(deflateBound(&z, uLong(end - begin)) + 16);
+            z.next_in = filtered.data() + begin;
+            z.avail_in = uInt(end - begin);
+            while (ok) {
+                z.next_out = reinterpret_cast<Bytef*>(out.data()) + z.total_out;
+                z.avail_out = uInt(out.size() - z.total_out);
+                int status = deflate(&z, final ? Z_FINISH : Z_SYNC_FLUSH);
+                if (final ? status == Z_STREAM_END : status == Z_OK and z.avail_out > 0) break;
+                // only a full output buffer is worth another round; anything else is an error or no progress
+                ok = (status == Z_OK or status == Z_BUF_ERROR) and z.avail_out == 0;
+                if (ok) out.resize(out.size() * 2);
+            }
+            out.resize(z.total_out);
+            deflateEnd(&z);
+            if (!ok) failed = true;
+            checksums[stripe] = adler32(adler32(0, nullptr, 0), filtered.data() + begin, uInt(end - begin));
+        });
+        if (failed) {
+            std::cerr << "Warning: zlib failed to compress the PNG" << std::endl;
+            return {};
+        }
+
+        std::vector<std::byte> zlib;
+        int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        int cmf = 0x78, flg = flevel << 6;
+        flg += (31 - (cmf * 256 + flg) % 31) % 31;
+        zlib.push_back(std::byte(cmf));
+        zlib.push_back(std::byte(flg));
+        uLong checksum = adler32(0, nullptr, 0);
+        for (int stripe = 0; stripe < stripes; stripe++) {
+            zlib.insert(zlib.end(), streams[stripe].begin(), streams[stripe].end());
+            std::size_t length = std::min(filtered.size() - std::size_t(stripe) * stripeRows * lineBytes, std::size_t(stripeRows) * lineBytes);
+            checksum = adler32_combine(checksum, checksums[stripe], z_off_t(length));
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) zlib.push_back(std::byte((checksum >> shift) & 0xff));
+
+        std::vector<std::byte> png;
+        png.reserve(zlib.size() + 64);
+        PutHeader(png, width, height);
+        constexpr std::size_t MaxChunk = std::size_t(1) << 20;
+        for (std::size_t offset = 0; offset < zlib.size(); offset += MaxChunk)
+            PutChunk(png, "IDAT", zlib.data() + offset, std::min(MaxChunk, zlib.size() - offset));
+        PutChunk(png, "IEND", nullptr, 0);
+        return png;
+    }
+
+    bool SVGExport::ParseFilter(const std::string& name, PNGFilter& filter) {
+        static const std::map<std::string, PNGFilter> names = {
+            { "none", PNGFilter::None }, { "sub", PNGFilter::Sub }, { "up", PNGFilter::Up },
+            { "average", PNGFilter::Average }, { "paeth", PNGFilter::Paeth }, { "adaptive", PNGFilter::Adaptive },
+        };
+        auto it = names.find(name);
+        if (it == names.end()) return false;
+        filter = it->second;
+        return true;
+    }
+
+    std::vector<std::byte> SVGExport::EncodeICO(std::span<const std::vector<std::byte>> pngs, std::span<const int> sizes) {
+        std::vector<std::byte> bytes;
+        auto put = [&](std::uint32_t value, int count) {
+            for (int i = 0; i < count; i++) bytes.push_back(std::byte((value >> (8 * i)) & 0xff));
+        };
+        // ICONDIR, one ICONDIRENTRY per image, then the PNG streams; all little-endian
+        put(0, 2), put(1, 2), put(pngs.size(), 2);
+        std::size_t offset = 6 + 16 * pngs.size();
+        for (std::size_t i = 0; i < pngs.size(); i++) {
+            int size = sizes[i] >= 256 ? 0 : sizes[i];   // 0 stands for 256
+            put(size, 1), put(size, 1), put(0, 1), put(0, 1);
+            put(1, 2), put(24, 2);
+            put(pngs[i].size(), 4), put(offset, 4);
+            offset += pngs[i].size();
+        }
+        for (auto& png : pngs) bytes.insert(bytes.end(), png.begin(), png.end());
+        return bytes;
+    }
+
+    bool SVGExport::WriteFile(const std::filesystem::path& path, std::span<const std::byte> bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if (!file) {
+            std::cerr << "Warning: failed to write:" << path.string() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool SVGImageSink::Fail(const std::string& what) {
+        if (!_failed) std::cerr << "Warning: " << what << std::endl;
+        _failed = true;
+        return false;
+    }
+
+    bool SVGImageSink::Accept(int count) {
+        if (_failed) return false;
+        if (_rows + count > _height) return Fail("more rows than the image height");
+        _rows += count;
+        return true;
+    }
+
+    struct SVGPNGWriter::Stream {
+        z_stream z {};
+    };
+
+    SVGPNGWriter::SVGPNGWriter(const std::filesystem::path& path, int width, int height, const PNGOptions& options):
+        SVGImageSink(width, height),
+        _file(path, std::ios::binary | std::ios::trunc),
+        _path(path),
+        _options(options),
+        _stream(std::make_unique<Stream>()),
+        _prior(std::size_t(width) * BytesPerPixel, 0) {
+        if (deflateInit(&_stream->z, std::clamp(options.level, 0, 9)) != Z_OK) Fail("zlib failed to initialize for:" + path.string());
+        _chunk.resize(std::size_t(1) << 16);
+        std::vector<std::byte> header;
+        PutHeader(header, width, height);
+        Emit(header);
+    }
+
+    SVGPNGWriter::~SVGPNGWriter() {
+        deflateEnd(&_stream->z);
+    }
+
+    void SVGPNGWriter::Emit(const std::vector<std::byte>& bytes) {
+        _file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if (!_file) Fail("failed to write:" + _path.string());
+    }
+
+    bool SVGPNGWriter::Deflate(const std::uint8_t* data, std::size_t size, int flush) {
+        if (_failed) return false;
+        _stream->z.next_in = const_cast<Bytef*>(data);
+        _stream->z.avail_in = uInt(size);
+        int status;
+        do {
+            _stream->z.next_out = reinterpret_cast<Bytef*>(_chunk.data());
+            _stream->z.avail_out = uInt(_chunk.size());
+            status = deflate(&_stream->z, flush);
+            if (status != Z_OK and status != Z_STREAM_END and status != Z_BUF_ERROR) return Fail("zlib failed to compress:" + _path.string());
+            std::size_t produced = _chunk.size() - _stream->z.avail_out;
+            if (produced > 0) {
+                std::vector<std::byte> chunk;
+                PutChunk(chunk, "IDAT", _chunk.data(), produced);
+                Emit(chunk);
+            }
+        } while (_stream->z.avail_out == 0 and status != Z_STREAM_END);
+        return !_failed;
+    }
+
+    bool SVGPNGWriter::WriteRows(std::span<const std::byte> rows, int count) {
+        if (!Accept(count)) return false;
+        if (count == 0) return true;
+        std::size_t rowBytes = _prior.size(), lineBytes = rowBytes + 1;
+        auto pixels = reinterpret_cast<const std::uint8_t*>(rows.data());
+        _filtered.resize(lineBytes * count);
+        constexpr int GroupRows = 16;
+        Engine::ParallelFor(0, (count + GroupRows - 1) / GroupRows, [&](int group) {
+            std::vector<std::uint8_t> scratch;
+            int last = std::min(count, (group + 1) * GroupRows);
+            for (int y = group * GroupRows; y < last; y++)
+                FilterRow(_options, pixels + y * rowBytes, y > 0 ? pixels + (y - 1) * rowBytes : _prior.data(), rowBytes, _filtered.data() + y * lineBytes, scratch);
+        });
+        std::memcpy(_prior.data(), pixels + (count - 1) * rowBytes, rowBytes);
+        return Deflate(_filtered.data(), _filtered.size(), Z_NO_FLUSH);
+    }
+
+    bool SVGPNGWriter::Finish() {
+        if (_failed) return false;
+        if (_rows != _height) return Fail("image ended after " + std::to_string(_rows) + " of " + std::to_string(_height) + " rows");
+        if (!Deflate(nullptr, 0, Z_FINISH)) return false;
+        std::vector<std::byte> end;
+        PutChunk(end, "IEND", nullptr, 0);
+        Emit(end);
+        _file.close();
+        return !_failed;
+    }
+
+    SVGPNMWriter::SVGPNMWriter(const std::filesystem::path& path, int width, int height, bool pam):
+        SVGImageSink(width, height),
+        _file(path, std::ios::binary | std::ios::trunc),
+        _path(path) {
+        if (pam) _file << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n";
+        else _file << "P6\n" << width << " " << height << "\n255\n";
+        if (!_file) Fail("failed to write:" + _path.string());
+    }
+
+    bool SVGPNMWriter::WriteRows(std::span<const std::byte> rows, int count) {
+        if (!Accept(count)) return false;
+        _file.write(reinterpret_cast<const char*>(rows.data()), std::streamsize(std::size_t(count) * _width * BytesPerPixel));
+        if (!_file) return Fail("failed to write:" + _path.string());
+        return true;
+    }
+
+    bool SVGPNMWriter::Finish() {
+        if (_failed) return false;
+        if (_rows != _height) return Fail("image ended after " + std::to_string(_rows) + " of " + std::to_string(_height) + " rows");
+        _file.close();
+        if (!_file) return Fail("failed to write:" + _path.string());
+        return true;
+    }
+}
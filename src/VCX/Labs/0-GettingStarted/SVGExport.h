@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "Labs/Common/ImageRGB.h"
+
+namespace VCX::Labs::GettingStarted {
+    // PNG row filters; Adaptive picks per row the one with the smallest sum of absolute residuals
+    enum class PNGFilter { None, Sub, Up, Average, Paeth, Adaptive };
+
+    struct PNGOptions {
+        int       level  = 6;   // zlib level, 0 (store) to 9
+        PNGFilter filter = PNGFilter::Adaptive;
+    };
+
+    // encoders and file output shared by the export button and the headless tools
+    class SVGExport {
+    public:
+        // straight from the image's RGB8 bytes; rows are filtered and deflated in parallel stripes,
+        // each a raw deflate stream primed with the preceding 32 KiB and closed by a sync flush;
+        // empty (with a warning) for an empty image or when zlib fails
+        static std::vector<std::byte> EncodePNG(const Common::ImageRGB& image, const PNGOptions& options = {});
+        static std::vector<std::byte> EncodePNG(std::span<const std::byte> rgb, int width, int height, const PNGOptions& options = {});
+        // "none", "sub", "up", "average", "paeth" or "adaptive"; false leaves `filter` untouched
+        static bool ParseFilter(const std::string& name, PNGFilter& filter);
+        // multi-resolution .ico embedding already encoded square PNGs of edge `sizes[i]` (at most 256)
+        static std::vector<std::byte> EncodeICO(std::span<const std::vector<std::byte>> pngs, std::span<const int> sizes);
+        // false (with a warning) when the file cannot be written
+        static bool WriteFile(const std::filesystem::path& path, std::span<const std::byte> bytes);
+    };
+
+    // receives an image top to bottom in bands of whole RGB8 rows, so the full frame never has to exist at once
+    class SVGImageSink {
+    public:
+        SVGImageSink(int width, int height): _width(width), _height(height) {}
+        virtual ~SVGImageSink() = default;
+
+        int GetWidth() const { return _width; }
+        int GetHeight() const { return _height; }
+
+        // `rows` holds `count` rows of GetWidth() pixels; false (with one warning) once output has failed
+        virtual bool WriteRows(std::span<const std::byte> rows, int count) = 0;
+        // completes the file after the last row; false if it is short or anything failed
+        virtual bool Finish() = 0;
+
+    protected:
+        int  _width, _height;
+        int  _rows = 0;
+        bool _failed = false;
+
+        bool Fail(const std::string& what);
+        bool Accept(int count);
+    };
+
+    // PNG through a single deflate stream: memory is one band of filtered rows plus the zlib window
+    class SVGPNGWriter : public SVGImageSink {
+    public:
+        SVGPNGWriter(const std::filesystem::path& path, int width, int height, const PNGOptions& options = {});
+        ~SVGPNGWriter();
+        SVGPNGWriter(const SVGPNGWriter&) = delete;
+        SVGPNGWriter& operator=(const SVGPNGWriter&) = delete;
+
+        bool WriteRows(std::span<const std::byte> rows, int count) override;
+        bool Finish() override;
+
+    private:
+        std::ofstream             _file;
+        std::filesystem::path     _path;
+        PNGOptions                _options;
+        struct Stream;                         // the zlib state, kept out of this header
+        std::unique_ptr<Stream>   _stream;
+        std::vector<std::uint8_t> _prior;      // last row of the previous band, unfiltered
+        std::vector<std::uint8_t> _filtered;
+        std::vector<std::byte>    _chunk;      // deflate output, emitted as one IDAT whenever it fills
+
+        void Emit(const std::vector<std::byte>& bytes);
+        bool Deflate(const std::uint8_t* data, std::size_t size, int flush);
+    };
+
+    // binary PPM (P6), or PAM (P7) when `pam`; rows are written through as they arrive
+    class SVGPNMWriter : public SVGImageSink {
+    public:
+        SVGPNMWriter(const std::filesystem::path& path, int width, int height, bool pam = false);
+
+        bool WriteRows(std::span<const std::byte> rows, int count) override;
+        bool Finish() override;
+
+    private:
+        std::ofstream         _file;
+        std::filesystem::path _path;
+    };
+}
@@ -0,0 +1,152 @@
+#include "SVGFont.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <stb_truetype.h>
+#include "Assets/bundled.h"
+#include "Engine/loader.h"
+
+namespace VCX::Labs::GettingStarted {
+
+    struct SVGFont::Data {
+        std::string                name;
+        std::vector<unsigned char> bytes;
+        stbtt_fontinfo             info;
+        float                      emScale;   // font units -> outline units
+
+        mutable std::mutex                                       mutex;
+        mutable std::map<int, std::shared_ptr<const Definition>> outlines;
+    };
+
+    static std::mutex                                     g_FontMutex;
+    static std::map<std::string, std::unique_ptr<SVGFont>> g_Fonts;   // failed loads stay as nullptr
+
+    SVGFont::~SVGFont() = default;
+
+    const SVGFont* SVGFont::Get(const std::string& family) {
+        std::string lower = family;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        bool mono = lower.find("mono") != std::string::npos or lower.find("courier") != std::string::npos or lower.find("consolas") != std::string::npos;
+        return Load(std::string(Assets::DefaultFonts[mono ? 1 : 0]));
+    }
+
+    const SVGFont* SVGFont::Find(const std::string& name) {
+        for (auto path : Assets::DefaultFonts)
+            if (name == path) return Load(name);
+        return nullptr;
+    }
+
+    const SVGFont* SVGFont::Load(const std::string& path) {
+        std::lock_guard lock(g_FontMutex);
+        auto it = g_Fonts.find(path);
+        if (it != g_Fonts.end()) return it->second.get();
+
+        auto& font = g_Fonts[path];
+        std::ifstream file(Engine::ResolveAsset(path), std::ios::binary);
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.empty()) {
+            std::cerr << "Warning: failed to load font:" << path << std::endl;
+            return nullptr;
+        }
+        font.reset(new SVGFont());
+        font->_data = std::make_unique<Data>();
+        Data& data = *font->_data;
+        data.name = path;
+        data.bytes = std::move(bytes);
+        if (!stbtt_InitFont(&data.info, data.bytes.data(), stbtt_GetFontOffsetForIndex(data.bytes.data(), 0))) {
+            std::cerr << "Warning: failed to parse font:" << path << std::endl;
+            font.reset();
+            return nullptr;
+        }
+        data.emScale = stbtt_ScaleForMappingEmToPixels(&data.info, EmUnits);
+        return font.get();
+    }
+
+    const std::string& SVGFont::GetName() const {
+        return _data->name;
+    }
+
+    int SVGFont::FindGlyph(int codepoint) const {
+        return stbtt_FindGlyphIndex(&_data->info, codepoint);
+    }
+
+    float SVGFont::GetAdvance(int glyph) const {
+        int advance = 0, lsb = 0;
+        stbtt_GetGlyphHMetrics(&_data->info, glyph, &advance, &lsb);
+        return advance * _data->emScale / EmUnits;
+    }
+
+    float SVGFont::GetKerning(int glyph, int next) const {
+        return stbtt_GetGlyphKernAdvance(&_data->info, glyph, next) * _data->emScale / EmUnits;
+    }
+
+    // uniform subdivision; for step h the chord error of a bezier is at most |B''| h^2 / 8
+    static constexpr float FlattenTolerance = 0.25f;   // outline units
+
+    static void FlattenQuadratic(glm::vec2 p0, glm::vec2 p1, glm::vec2 p2, float tolerance, std::vector<glm::vec2>& points) {
+        float dd = glm::length(p0 - 2.0f * p1 + p2);
+        int n = std::clamp((int)std::ceil(std::sqrt(dd / (4.0f * tolerance))), 1, 64);
+        for (int i = 1; i <= n; i++) {
+            float t = (float)i / n, s = 1.0f - t;
+            points.push_back(s * s * p0 + 2.0f * s * t * p1 + t * t * p2);
+        }
+    }
+
+    static void FlattenCubic(glm::vec2 p0, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, float tolerance, std::vector<glm::vec2>& points) {
+        float dd = std::max(glm::length(p0 - 2.0f * p1 + p2), glm::length(p1 - 2.0f * p2 + p3));
+        int n = std::clamp((int)std::ceil(std::sqrt(6.0f * dd / (8.0f * tolerance))), 1, 64);
+        for (int i = 1; i <= n; i++) {
+            float t = (float)i / n, s = 1.0f - t;
+            points.push_back(s * s * s * p0 + 3.0f * s * s * t * p1 + 3.0f * s * t * t * p2 + t * t * t * p3);
+        }
+    }
+
+    Path SVGFont::Flatten(int glyph, float tolerance) const {
+        stbtt_vertex* vertices = nullptr;
+        int count = stbtt_GetGlyphShape(&_data->info, glyph, &vertices);
+        auto map = [&](float x, float y) { return glm::vec2(x, -y) * _data->emScale; };
+
+        Path path;
+        glm::vec2 last(0.0f);
+        for (int i = 0; i < count; i++) {
+            const stbtt_vertex& v = vertices[i];
+            glm::vec2 p = map(v.x, v.y);
+            if (v.type == STBTT_vmove) path.sub_paths.push_back({ p });
+            else if (!path.sub_paths.empty()) {
+                auto& points = path.sub_paths.back();
+                if (v.type == STBTT_vline) points.push_back(p);
+                else if (v.type == STBTT_vcurve) FlattenQuadratic(last, map(v.cx, v.cy), p, tolerance, points);
+                else if (v.type == STBTT_vcubic) FlattenCubic(last, map(v.cx, v.cy), map(v.cx1, v.cy1), p, tolerance, points);
+            }
+            last = p;
+        }
+        stbtt_FreeShape(&_data->info, vertices);
+        return path;
+    }
+
+    std::shared_ptr<const Definition> SVGFont::GetOutline(int glyph) const {
+        std::lock_guard lock(_data->mutex);
+        auto it = _data->outlines.find(glyph);
+        if (it != _data->outlines.end()) return it->second;
+
+        auto& outline = _data->outlines[glyph];
+        Path* path = new Path(Flatten(glyph, FlattenTolerance));
+        if (path->sub_paths.empty()) {
+            delete path;
+            return outline;
+        }
+        auto definition = std::make_shared<Definition>();
+        definition->id = _data->name + "#" + std::to_string(glyph);
+        definition->entries.push_back({ path, {}, glm::mat3(1.0f) });
+        definition->font = this;
+        definition->glyph = glyph;
+        outline = definition;
+        return outline;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "SVGData.h"
+
+namespace VCX::Labs::GettingStarted {
+    // Glyph outlines are flattened once per (font, glyph) and shared process-wide as single-entry
+    // Definitions, so every placed glyph is a <use>-like instance; the rasterizer keeps anti-aliased
+    // coverage per glyph, size and subpixel offset. Outline space: 1 em = EmUnits, y down, origin on
+    // the baseline.
+    class SVGFont {
+    public:
+        static constexpr float EmUnits = 1024.0f;
+
+        // the bundled Ubuntu / Ubuntu Mono faces; nullptr when the file cannot be loaded
+        static const SVGFont* Get(const std::string& family);
+        // the bundled face whose GetName() is `name`, for outlines read back from a display list
+        static const SVGFont* Find(const std::string& name);
+
+        const std::string& GetName() const;
+        int   FindGlyph(int codepoint) const;
+        float GetAdvance(int glyph) const;              // in em
+        float GetKerning(int glyph, int next) const;    // in em
+        // nullptr for glyphs without an outline (spaces)
+        std::shared_ptr<const Definition> GetOutline(int glyph) const;
+        // the outline flattened to `tolerance` outline units, for rasterizing at a known device scale
+        Path Flatten(int glyph, float tolerance) const;
+
+        ~SVGFont();
+
+    private:
+        SVGFont() = default;
+        static const SVGFont* Load(const std::string& path);
+        struct Data;
+        std::unique_ptr<Data> _data;
+    };
+}
@@ -0,0 +1,142 @@
+#include "SVGImage.h"
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Engine/loader.h"
+
+namespace VCX::Labs::GettingStarted {
+
+    struct CacheEntry {
+        std::shared_ptr<const Bitmap>       bitmap;
+        std::size_t                         bytes;
+        std::list<std::uint64_t>::iterator  order;
+    };
+
+    static std::mutex                          g_ImageMutex;
+    static std::list<std::uint64_t>            g_ImageOrder;   // most recently used first
+    static std::map<std::uint64_t, CacheEntry> g_Images;
+    static std::size_t                         g_ImageBytes = 0;
+
+    static std::vector<std::byte> DecodeBase64(std::string_view text) {
+        std::vector<std::byte> bytes;
+        bytes.reserve(text.size() / 4 * 3);
+        unsigned int buffer = 0;
+        int bits = 0;
+        for (char c : text) {
+            int v;
+            if (c >= 'A' and c <= 'Z') v = c - 'A';
+            else if (c >= 'a' and c <= 'z') v = c - 'a' + 26;
+            else if (c >= '0' and c <= '9') v = c - '0' + 52;
+            else if (c == '+' or c == '-') v = 62;
+            else if (c == '/' or c == '_') v = 63;
+            else continue;   // padding and embedded whitespace
+            buffer = (buffer << 6) | v;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                bytes.push_back(std::byte((buffer >> bits) & 0xFF));
+            }
+        }
+        return bytes;
+    }
+
+    // FNV-1a over the encoded bytes
+    static std::uint64_t HashBytes(const std::vector<std::byte>& bytes) {
+        std::uint64_t hash = 1469598103934665603ull;
+        for (std::byte b : bytes) {
+            hash ^= std::uint64_t(b);
+            hash *= 1099511628211ull;
+        }
+        return hash ^ bytes.size();
+    }
+
+    // 2x2 box filter per level down to 1x1; odd edges repeat the last texel
+    static void BuildMips(Bitmap& bitmap) {
+        while (bitmap.levels.back().width > 1 or bitmap.levels.back().height > 1) {
+            const Bitmap::Level& src = bitmap.levels.back();
+            Bitmap::Level dst;
+            dst.width = (src.width + 1) / 2;
+            dst.height = (src.height + 1) / 2;
+            dst.pixels.resize(dst.width * dst.height);
+            for (int j = 0; j < dst.height; j++)
+                for (int i = 0; i < dst.width; i++) {
+                    int x0 = 2 * i, x1 = std::min(2 * i + 1, src.width - 1);
+                    int y0 = 2 * j, y1 = std::min(2 * j + 1, src.height - 1);
+                    glm::vec4 sum = glm::vec4(src.pixels[y0 * src.width + x0]) + glm::vec4(src.pixels[y0 * src.width + x1])
+                                  + glm::vec4(src.pixels[y1 * src.width + x0]) + glm::vec4(src.pixels[y1 * src.width + x1]);
+                    dst.pixels[j * dst.width + i] = glm::u8vec4(glm::round(sum * 0.25f));
+                }
+            bitmap.levels.push_back(std::move(dst));
+        }
+    }
+
+    std::filesystem::path SVGImage::ResolvePath(const std::string& href, const std::string& directory) {
+        if (href.compare(0, 5, "data:") == 0) return {};
+        return std::filesystem::path(directory) / (href.compare(0, 7, "file://") == 0 ? href.substr(7) : href);
+    }
+
+    std::shared_ptr<const Bitmap> SVGImage::Load(const std::string& href, const std::string& directory) {
+        std::vector<std::byte> bytes;
+        if (href.compare(0, 5, "data:") == 0) {
+            auto comma = href.find(',');
+            if (comma == std::string::npos or href.substr(0, comma).find(";base64") == std::string::npos) {
+                std::cerr << "Warning: only base64 data URIs are supported for <image>" << std::endl;
+                return nullptr;
+            }
+            bytes = DecodeBase64(std::string_view(href).substr(comma + 1));
+        } else bytes = Engine::LoadBytes(ResolvePath(href, directory));
+        if (bytes.empty()) return nullptr;
+
+        std::uint64_t key = HashBytes(bytes);
+        {
+            std::lock_guard lock(g_ImageMutex);
+            auto it = g_Images.find(key);
+            if (it != g_Images.end()) {
+                g_ImageOrder.splice(g_ImageOrder.begin(), g_ImageOrder, it->second.order);
+                return it->second.bitmap;
+            }
+        }
+
+        const auto texture = Engine::LoadImageRGBA(std::span<std::byte const>(bytes));
+        if (texture.GetSizeX() == 0 or texture.GetSizeY() == 0) {
+            std::cerr << "Warning: failed to decode <image>:" << (href.size() > 64 ? href.substr(0, 64) + "..." : href) << std::endl;
+            return nullptr;
+        }
+        auto bitmap = std::make_shared<Bitmap>();
+        Bitmap::Level level;
+        level.width = (int)texture.GetSizeX();
+        level.height = (int)texture.GetSizeY();
+        level.pixels.resize(level.width * level.height);
+        for (int j = 0; j < level.height; j++)
+            for (int i = 0; i < level.width; i++) {
+                glm::vec4 c = texture.At(i, j);
+                level.pixels[j * level.width + i] = Engine::Formats::RGBA8::Encode(glm::vec4(glm::vec3(c) * c.a, c.a));
+            }
+        bitmap->levels.push_back(std::move(level));
+        BuildMips(*bitmap);
+
+        std::size_t size = 0;
+        for (auto& l : bitmap->levels) size += l.pixels.size() * sizeof(glm::u8vec4);
+
+        std::lock_guard lock(g_ImageMutex);
+        auto [it, inserted] = g_Images.try_emplace(key);
+        if (!inserted) return it->second.bitmap;   // decoded concurrently
+        g_ImageOrder.push_front(key);
+        it->second = { bitmap, size, g_ImageOrder.begin() };
+        g_ImageBytes += size;
+        // scenes keep their own references, so evicting only drops the cache's share
+        while (g_ImageBytes > CacheBytes and g_ImageOrder.size() > 1) {
+            auto victim = g_Images.find(g_ImageOrder.back());
+            g_ImageBytes -= victim->second.bytes;
+            g_Images.erase(victim);
+            g_ImageOrder.pop_back();
+        }
+        return bitmap;
+    }
+}
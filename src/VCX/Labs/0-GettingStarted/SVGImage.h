@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "SVGData.h"
+
+namespace VCX::Labs::GettingStarted {
+    // Decoded <image> bitmaps, shared process-wide through an LRU keyed by a hash of the encoded bytes,
+    // so the same picture embedded twice (or re-parsed on reload) is decoded once.
+    class SVGImage {
+    public:
+        static constexpr std::size_t CacheBytes = std::size_t(256) << 20;
+
+        // `href` is a base64 data: URI or a path relative to `directory`; nullptr when it cannot be decoded
+        static std::shared_ptr<const Bitmap> Load(const std::string& href, const std::string& directory);
+        // the file `href` names relative to `directory`, empty for data: URIs
+        static std::filesystem::path ResolvePath(const std::string& href, const std::string& directory);
+    };
+}
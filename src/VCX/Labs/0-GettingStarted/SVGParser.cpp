@@ -1,10 +1,16 @@
 #include "SVGParser.h"
+#include "SVGFont.h"
+#include "SVGImage.h"
+#include <filesystem>
 #include <sstream>
 #include <iostream>
 #include <string.h>
 #include <map>
+#include <array>
+#include <tuple>
 #include <algorithm>
 #include <cctype>
+#include <functional>
 
 namespace VCX::Labs::GettingStarted {
 
@@ -119,8 +125,25 @@ namespace VCX::Labs::GettingStarted {
         glm::vec2 Transform(glm::vec2 p) const {
             return { p.x * scale + offsetX, p.y * scale + offsetY };
         }
+
+        glm::mat3 Matrix() const {
+            glm::mat3 m(scale);
+            m[2][0] = offsetX;
+            m[2][1] = offsetY;
+            m[2][2] = 1.0f;
+            return m;
+        }
     } box;
 
+    // elements with an id attribute, and the definitions already flattened for <use>
+    static std::map<std::string, tinyxml2::XMLElement*> g_Elements;
+    static std::map<std::pair<std::string, int>, std::shared_ptr<Definition>> g_Definitions;   // by id and log2 scale bucket
+    static std::map<std::string, std::shared_ptr<Gradient>> g_Gradients;
+    static std::map<std::tuple<std::string, std::array<float, 6>, const ClipPath*, int>, std::shared_ptr<const ClipPath>> g_Clips;
+    static std::string g_Directory;   // of the document, for relative <image> paths
+    static std::vector<ElementId> g_Ids;
+    static int g_Enclosing = -1;       // index in g_Ids of the element being parsed
+
     int mystrncasecmp(const char* a, const char* b, const int n) {
         if (!a or !b) return 0;
         for (int i = 0; i < n && *a && *b; a++, b++, i++) {
@@ -150,6 +173,41 @@ namespace VCX::Labs::GettingStarted {
         {"bevel", StrokeLinejoin::Bevel}    
     };
 
+    // "none" or a list of lengths; odd lists repeat to an even count, invalid or all-zero lists mean solid
+    std::vector<float> ParseDasharray(const std::string& value) {
+        std::vector<float> dashes;
+        std::string asstring = value;
+        std::replace(asstring.begin(), asstring.end(), ',', ' ');
+        std::stringstream ss(asstring);
+        float sum = 0;
+        for (std::string item; ss >> item;) {
+            char* end = nullptr;
+            float v = std::strtof(item.c_str(), &end);
+            if (end == item.c_str() or v < 0) return {};
+            dashes.push_back(v);
+            sum += v;
+        }
+        if (sum <= 0) return {};
+        if (dashes.size() % 2 == 1) dashes.insert(dashes.end(), dashes.begin(), dashes.end());
+        return dashes;
+    }
+
+    static const std::map<std::string, TextAnchor> TextAnchorMap = {
+        {"start", TextAnchor::Start},
+        {"middle", TextAnchor::Middle},
+        {"end", TextAnchor::End}
+    };
+
+    // absolute font-size in user units; keywords and relative sizes are not supported
+    std::optional<float> ParseFontSize(const std::string& value) {
+        char* end = nullptr;
+        float size = std::strtof(value.c_str(), &end);
+        if (end == value.c_str() or size <= 0) return std::nullopt;
+        std::string unit = end;
+        if (unit == "pt") size *= 4.0f / 3.0f;
+        return size;
+    }
+
     static const std::map<std::string, glm::vec4> g_ColorMap = {
         {"aliceblue", {0.941f, 0.973f, 1.0f, 1.0f}}, {"antiquewhite", {0.98f, 0.922f, 0.843f, 1.0f}},
         {"aqua", {0.0f, 1.0f, 1.0f, 1.0f}}, {"aquamarine", {0.498f, 1.0f, 0.831f, 1.0f}},
@@ -287,6 +345,24 @@ namespace VCX::Labs::GettingStarted {
         return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
     }
     
+    // fill/stroke value: a color, or url(#id) naming a paint server
+    bool ParsePaintServer(const std::string& value, std::optional<glm::vec4>& color, std::optional<std::string>& server) {
+        if (value.compare(0, 4, "url(") != 0) {
+            server = "";
+            return false;
+        }
+        auto begin = value.find('#');
+        auto end = value.find(')');
+        if (begin == std::string::npos or end == std::string::npos or end < begin) {
+            server = "";
+            color = glm::vec4(0.0f);
+            return true;
+        }
+        server = Trim(value.substr(begin + 1, end - begin - 1));
+        color = glm::vec4(1.0f);
+        return true;
+    }
+
     void SVGParser::ParseStyleAttribute(const char* styleStr, ShapeStyle& style) {
         if (!styleStr) return;
         
@@ -300,9 +376,11 @@ namespace VCX::Labs::GettingStarted {
             std::string val = Trim(item.substr(colonPos + 1));
     
             if (key == "fill") {
-                style.fill = SVGParser::ParseColor(val.c_str());
+                if (!ParsePaintServer(val, style.fill, style.fillPaint))
+                    style.fill = SVGParser::ParseColor(val.c_str());
             } else if (key == "stroke") {
-                style.stroke = SVGParser::ParseColor(val.c_str());
+                if (!ParsePaintServer(val, style.stroke, style.strokePaint))
+                    style.stroke = SVGParser::ParseColor(val.c_str());
             } else if (key == "stroke-width") {
                 style.strokeWidth = std::stof(val);
             } else if (key == "opacity") {
@@ -315,18 +393,39 @@ namespace VCX::Labs::GettingStarted {
                 style.strokeLinecap = LinecapMap.find(val)->second;
             } else if (key == "stroke-linejoin") {
                 style.strokeLinejoin = LinejoinMap.find(val)->second;
+            } else if (key == "stroke-dasharray") {
+                style.strokeDasharray = ParseDasharray(val);
+            } else if (key == "stroke-dashoffset") {
+                style.strokeDashoffset = std::stof(val);
+            } else if (key == "font-size") {
+                if (auto size = ParseFontSize(val)) style.fontSize = size;
+            } else if (key == "font-family") {
+                style.fontFamily = val;
+            } else if (key == "text-anchor") {
+                auto it = TextAnchorMap.find(val);
+                if (it != TextAnchorMap.end()) style.textAnchor = it->second;
             }
         }
     }
 
     ShapeStyle SVGParser::ParseStyle(tinyxml2::XMLElement* elem) {
         ShapeStyle style;
-        if (auto f = elem->Attribute("fill")) style.fill = SVGParser::ParseColor(f);
-        if (auto s = elem->Attribute("stroke")) style.stroke = SVGParser::ParseColor(s);
+        if (auto f = elem->Attribute("fill"))
+            if (!ParsePaintServer(f, style.fill, style.fillPaint)) style.fill = SVGParser::ParseColor(f);
+        if (auto s = elem->Attribute("stroke"))
+            if (!ParsePaintServer(s, style.stroke, style.strokePaint)) style.stroke = SVGParser::ParseColor(s);
         if (elem->Attribute("stroke-width")) style.strokeWidth = elem->FloatAttribute("stroke-width");
         if (elem->Attribute("opacity")) style.opacity = elem->FloatAttribute("opacity");
         if (elem->Attribute("fill-opacity")) style.fillOpacity = elem->FloatAttribute("fill-opacity");
         if (elem->Attribute("stroke-opacity")) style.strokeOpacity = elem->FloatAttribute("stroke-opacity");
+        if (auto da = elem->Attribute("stroke-dasharray")) style.strokeDasharray = ParseDasharray(da);
+        if (elem->Attribute("stroke-dashoffset")) style.strokeDashoffset = elem->FloatAttribute("stroke-dashoffset");
+        if (auto fs = elem->Attribute("font-size")) style.fontSize = ParseFontSize(fs);
+        if (auto ff = elem->Attribute("font-family")) style.fontFamily = ff;
+        if (auto ta = elem->Attribute("text-anchor")) {
+            auto it = TextAnchorMap.find(ta);
+            if (it != TextAnchorMap.end()) style.textAnchor = it->second;
+        }
         if (auto stylestr = elem->Attribute("style")) {
             ParseStyleAttribute(stylestr, style);
         }
@@ -339,24 +438,23 @@ namespace VCX::Labs::GettingStarted {
         return style;
     }
 
-    RenderStyle InheritStyle(const RenderStyle& parent, const ShapeStyle& local) {
-        RenderStyle result = parent;
-        if (local.fill) result.fill = *local.fill;
-        if (local.stroke) result.stroke = *local.stroke;
-        if (local.strokeWidth) result.strokeWidth = *local.strokeWidth;
-        if (local.opacity) result.totalOpacity *= (*local.opacity);
-        if (local.fillOpacity) {
-            result.fill.a = (*local.fillOpacity);
-        }
-        if (local.strokeOpacity) {
-            result.stroke.a = (*local.strokeOpacity);
-        }
-        if (local.strokeLinecap) {
-            result.linecap = (*local.strokeLinecap);
-        }
-        if (local.strokeLinejoin) {
-            result.linejoin = (*local.strokeLinejoin);
-        }
+    ShapeStyle MergeStyle(const ShapeStyle& parent, const ShapeStyle& local) {
+        ShapeStyle result = parent;
+        if (local.fill) result.fill = local.fill;
+        if (local.stroke) result.stroke = local.stroke;
+        if (local.strokeWidth) result.strokeWidth = local.strokeWidth;
+        if (local.opacity) result.opacity = parent.opacity.value_or(1.0f) * (*local.opacity);
+        if (local.fillOpacity) result.fillOpacity = local.fillOpacity;
+        if (local.strokeOpacity) result.strokeOpacity = local.strokeOpacity;
+        if (local.strokeLinecap) result.strokeLinecap = local.strokeLinecap;
+        if (local.strokeLinejoin) result.strokeLinejoin = local.strokeLinejoin;
+        if (local.strokeDasharray) result.strokeDasharray = local.strokeDasharray;
+        if (local.strokeDashoffset) result.strokeDashoffset = local.strokeDashoffset;
+        if (local.fillPaint) result.fillPaint = local.fillPaint;
+        if (local.strokePaint) result.strokePaint = local.strokePaint;
+        if (local.fontSize) result.fontSize = local.fontSize;
+        if (local.fontFamily) result.fontFamily = local.fontFamily;
+        if (local.textAnchor) result.textAnchor = local.textAnchor;
         return result;
     }
 
@@ -447,7 +545,8 @@ namespace VCX::Labs::GettingStarted {
         if (sweep_flag and dTheta < 0) dTheta += 2 * glm::pi<float>();
         if (!sweep_flag and dTheta > 0) dTheta -= 2 * glm::pi<float>();
 
-        int t = std::max(1, (int)(std::abs(dTheta) * 30 * box.scale));
+        // capped so huge recording details cannot overflow the segment count
+        int t = (int)std::clamp(std::abs(dTheta) * 30 * box.scale, 1.0f, 65536.0f);
         for (int i = 1; i <= t; i++) {
             float theta = theta1 + dTheta * (i / (float)t);
             float x = rx * std::cos(theta);
@@ -643,10 +742,7 @@ namespace VCX::Labs::GettingStarted {
         }
     }
     
-    void SVGParser::ParseElement(tinyxml2::XMLElement* elem, std::vector<Shape*>& shapes, const RenderStyle& parent, const glm::mat3& parentTransform) {
-        if (!elem) return;
-        auto local = ParseStyle(elem);
-        auto state = InheritStyle(parent, local);
+    glm::mat3 ParseTransformAttribute(tinyxml2::XMLElement* elem) {
         glm::mat3 localTransform = glm::mat3(1.0f);
         auto transformstr = elem->Attribute("transform");
         if (transformstr) {
@@ -656,11 +752,43 @@ namespace VCX::Labs::GettingStarted {
             }
             ParseTransform(transforms, localTransform);
         }
-        localTransform = parentTransform * localTransform;
-        float transformScale = std::sqrt(std::abs(glm::determinant(localTransform)));
-        
+        return localTransform;
+    }
 
-        Shape* shape = nullptr;
+    // presentation attribute, overridden by the same property in the style attribute
+    std::string GetProperty(tinyxml2::XMLElement* elem, const std::string& key) {
+        std::string value;
+        if (auto attr = elem->Attribute(key.c_str())) value = attr;
+        if (auto stylestr = elem->Attribute("style")) {
+            std::stringstream ss(stylestr);
+            std::string item;
+            while (std::getline(ss, item, ';')) {
+                size_t colonPos = item.find(':');
+                if (colonPos == std::string::npos) continue;
+                if (Trim(item.substr(0, colonPos)) == key) value = Trim(item.substr(colonPos + 1));
+            }
+        }
+        return value;
+    }
+
+    // id from "url(#id)", empty otherwise
+    std::string ParseUrl(const std::string& value) {
+        if (value.compare(0, 4, "url(") != 0) return "";
+        auto begin = value.find('#');
+        auto end = value.find(')');
+        if (begin == std::string::npos or end == std::string::npos or end < begin) return "";
+        return Trim(value.substr(begin + 1, end - begin - 1));
+    }
+
+    const char* GetHref(tinyxml2::XMLElement* elem) {
+        const char* href = elem->Attribute("href");
+        if (!href) href = elem->Attribute("xlink:href");
+        if (!href or href[0] != '#') return nullptr;
+        return href + 1;
+    }
+
+    Path* SVGParser::ParseGeometry(tinyxml2::XMLElement* elem, const glm::mat3& localTransform, float transformScale) {
+        Path* shape = nullptr;
         std::string name = elem->Name();
         if (name == "rect") {
             float x = elem->FloatAttribute("x");
@@ -687,7 +815,7 @@ namespace VCX::Labs::GettingStarted {
             path->sub_paths.push_back({});
             auto& pts = path->sub_paths.back();
             float worldRadius = std::max(rx, ry) * box.scale * transformScale;
-            int N = worldRadius * 20.0f; 
+            int N = std::min(worldRadius * 20.0f, 65536.0f);
             for (int i = 0; i < N; ++i) {
                 float theta = 2.0f * glm::pi<float>() * i / N;
                 float x = cx + rx * std::cos(theta);
@@ -760,7 +888,135 @@ namespace VCX::Labs::GettingStarted {
             path->sub_paths.back().push_back(box.Transform(ApplyTransform(glm::vec3{x2, y2, 1}, localTransform)));
             shape = path;
         }
-        else if (name == "g") {
+        return shape;
+    }
+
+    // canvas-space bounds of the geometry in shapes[first..], as x0, y0, x1, y1
+    glm::vec4 DeviceBounds(const std::vector<Shape*>& shapes, size_t first) {
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        auto add = [&](const Path* path, const glm::mat3& T) {
+            for (auto& subpath : path->sub_paths)
+                for (auto& p : subpath) {
+                    glm::vec2 q = glm::vec2(T * glm::vec3(p, 1.0f));
+                    lo = glm::min(lo, q);
+                    hi = glm::max(hi, q);
+                }
+        };
+        for (size_t i = first; i < shapes.size(); i++) {
+            if (shapes[i]->type == ShapeType::Path) add(static_cast<Path*>(shapes[i]), glm::mat3(1.0f));
+            else if (shapes[i]->type == ShapeType::Use) {
+                Use* use = static_cast<Use*>(shapes[i]);
+                for (auto& e : use->definition->entries) add(e.path, use->transform);
+            }
+        }
+        if (lo.x > hi.x) return { 0, 0, 0, 0 };
+        return { lo.x, lo.y, hi.x, hi.y };
+    }
+
+    // whether `shape` paints both a fill and a stroke, which overlap each other inside the one element
+    bool PaintsFillAndStroke(const Shape* shape) {
+        auto painted = [](const glm::vec4& color, const Paint& paint) { return color.a > 1e-6f or paint.gradient or paint.image; };
+        if (shape->type != ShapeType::Use)
+            return painted(shape->fillColor, shape->fillPaint) and painted(shape->strokeColor, shape->strokePaint) and shape->strokeWidth > 0;
+        auto use = static_cast<const Use*>(shape);
+        for (size_t i = 0; i < use->definition->entries.size(); i++) {
+            RenderStyle state = InheritStyle(use->style, use->definition->entries[i].style);
+            bool fill = painted(state.fill, use->fillPaints.empty() ? Paint() : use->fillPaints[i]);
+            bool stroke = painted(state.stroke, use->strokePaints.empty() ? Paint() : use->strokePaints[i]) and state.strokeWidth > 0;
+            if (fill and stroke) return true;
+        }
+        return false;
+    }
+
+    // wraps shapes[first..] in an isolated layer, or folds the opacity into them when nothing inside can overlap
+    void ComposeGroup(std::vector<Shape*>& shapes, size_t first, float opacity, std::shared_ptr<const Filter> filter) {
+        if (opacity >= 1.0f and !filter) return;
+        if (opacity <= 0.0f) {
+            for (size_t i = first; i < shapes.size(); i++) delete shapes[i];
+            shapes.resize(first);
+            return;
+        }
+        size_t count = 0;
+        for (size_t i = first; i < shapes.size(); i++)
+            count += shapes[i]->type == ShapeType::Use ? static_cast<Use*>(shapes[i])->definition->entries.size() : 1;
+        if (count > 1 or filter or std::any_of(shapes.begin() + first, shapes.end(), PaintsFillAndStroke)) {
+            Layer* begin = new Layer(ShapeType::LayerBegin);
+            begin->opacity = opacity;
+            begin->filter = filter;
+            shapes.insert(shapes.begin() + first, begin);
+            shapes.push_back(new Layer(ShapeType::LayerEnd));
+            return;
+        }
+        for (size_t i = first; i < shapes.size(); i++) {
+            shapes[i]->fillColor.a *= opacity;
+            shapes[i]->strokeColor.a *= opacity;
+            if (shapes[i]->type == ShapeType::Use) static_cast<Use*>(shapes[i])->style.totalOpacity *= opacity;
+        }
+    }
+
+    void SVGParser::ParseElement(tinyxml2::XMLElement* elem, std::vector<Shape*>& shapes, const RenderStyle& parent, const glm::mat3& parentTransform) {
+        if (!elem) return;
+        std::string name = elem->Name();
+        // only rendered through references
+        if (name == "defs" or name == "symbol" or name == "linearGradient" or name == "radialGradient" or name == "clipPath" or name == "filter") return;
+
+        auto local = ParseStyle(elem);
+        auto state = InheritStyle(parent, local);
+        glm::mat3 localTransform = parentTransform * ParseTransformAttribute(elem);
+        float transformScale = std::sqrt(std::abs(glm::determinant(localTransform)));
+        Path* shape = ParseGeometry(elem, localTransform, transformScale);
+
+        int enclosing = g_Enclosing;
+        if (auto id = elem->Attribute("id")) {
+            g_Ids.push_back({ id, enclosing });
+            g_Enclosing = (int)g_Ids.size() - 1;
+        }
+
+        std::string clipId = ParseUrl(GetProperty(elem, "clip-path"));
+        if (!clipId.empty()) state.clip = ResolveClip(clipId, localTransform, shape, state.clip, 0);
+
+        std::string filterId = ParseUrl(GetProperty(elem, "filter"));
+
+        // group opacity is applied when the subtree is composited, not per child
+        size_t first = shapes.size();
+        float groupOpacity = 1.0f;
+        if ((name == "g" or name == "use") and local.opacity and *local.opacity < 1.0f) {
+            groupOpacity = std::max(*local.opacity, 0.0f);
+            state.totalOpacity = parent.totalOpacity;
+        }
+        // ops not claimed by a descendant with an id, layer markers included, belong to this element
+        auto finish = [&] {
+            auto filter = filterId.empty() ? nullptr : ResolveFilter(filterId, localTransform, DeviceBounds(shapes, first));
+            ComposeGroup(shapes, first, groupOpacity, filter);
+            if (g_Enclosing != enclosing)
+                for (size_t i = first; i < shapes.size(); i++)
+                    if (shapes[i]->element < 0) shapes[i]->element = g_Enclosing;
+            g_Enclosing = enclosing;
+        };
+
+        if (name == "image") {
+            if (Path* image = ParseImage(elem, state, localTransform)) {
+                image->clip = state.clip;
+                shapes.push_back(image);
+            }
+            finish();
+            return;
+        }
+
+        if (name == "text") {
+            ParseText(elem, shapes, state, localTransform);
+            finish();
+            return;
+        }
+
+        if (name == "use") {
+            if (Use* use = ParseUse(elem, state, localTransform, transformScale)) {
+                use->style = state;
+                use->clip = state.clip;
+                shapes.push_back(use);
+            }
+            finish();
+            return;
         }
 
         if (shape) {
@@ -768,9 +1024,20 @@ namespace VCX::Labs::GettingStarted {
             shape->fillColor.a *= state.totalOpacity;
             shape->strokeColor = state.stroke;
             shape->strokeColor.a *= state.totalOpacity;
+            if (!state.fillPaint.empty()) {
+                shape->fillPaint = ResolvePaint(state.fillPaint, shape, box.Matrix() * localTransform);
+                if (!shape->fillPaint.gradient) shape->fillColor.a = 0;
+            }
+            if (!state.strokePaint.empty()) {
+                shape->strokePaint = ResolvePaint(state.strokePaint, shape, box.Matrix() * localTransform);
+                if (!shape->strokePaint.gradient) shape->strokeColor.a = 0;
+            }
             shape->strokeWidth = state.strokeWidth * box.scale * transformScale;
+            for (float dash : state.dashArray) shape->dashes.push_back(dash * box.scale * transformScale);
+            shape->dashOffset = state.dashOffset * box.scale * transformScale;
             shape->linecap = state.linecap;
             shape->linejoin = state.linejoin;
+            shape->clip = state.clip;
             shapes.push_back(shape);
         }
 
@@ -779,6 +1046,625 @@ namespace VCX::Labs::GettingStarted {
             ParseElement(child, shapes, state, localTransform);
             child = child->NextSiblingElement();
         }
+        finish();
+    }
+
+    // The visible part of the image becomes a quad filled with an image paint that maps canvas
+    // pixels back to bitmap texels.
+    Path* SVGParser::ParseImage(tinyxml2::XMLElement* elem, const RenderStyle& state, const glm::mat3& localTransform) {
+        const char* href = elem->Attribute("href");
+        if (!href) href = elem->Attribute("xlink:href");
+        if (!href) return nullptr;
+        auto bitmap = SVGImage::Load(href, g_Directory);
+        if (!bitmap) return nullptr;
+
+        float imageWidth = bitmap->levels[0].width, imageHeight = bitmap->levels[0].height;
+        float x = elem->FloatAttribute("x"), y = elem->FloatAttribute("y");
+        float width = elem->FloatAttribute("width", imageWidth), height = elem->FloatAttribute("height", imageHeight);
+        if (width <= 0 or height <= 0) return nullptr;
+
+        // preserveAspectRatio="<align> [meet | slice]", xMidYMid meet by default
+        std::string aspect = elem->Attribute("preserveAspectRatio") ? elem->Attribute("preserveAspectRatio") : "xMidYMid meet";
+        glm::vec2 scale = { width / imageWidth, height / imageHeight };
+        glm::vec2 offset = { x, y };
+        if (aspect.compare(0, 4, "none") != 0) {
+            float s = aspect.find("slice") != std::string::npos ? std::max(scale.x, scale.y) : std::min(scale.x, scale.y);
+            float ax = aspect.find("xMin") != std::string::npos ? 0.0f : aspect.find("xMax") != std::string::npos ? 1.0f : 0.5f;
+            float ay = aspect.find("YMin") != std::string::npos ? 0.0f : aspect.find("YMax") != std::string::npos ? 1.0f : 0.5f;
+            offset += glm::vec2((width - imageWidth * s) * ax, (height - imageHeight * s) * ay);
+            scale = glm::vec2(s);
+        }
+        glm::vec2 lo = glm::max(offset, glm::vec2(x, y));
+        glm::vec2 hi = glm::min(offset + glm::vec2(imageWidth, imageHeight) * scale, glm::vec2(x + width, y + height));
+
+        Path* path = new Path();
+        path->sub_paths.push_back({});
+        for (glm::vec2 corner : { lo, glm::vec2(hi.x, lo.y), hi, glm::vec2(lo.x, hi.y) })
+            path->sub_paths.back().push_back(box.Transform(ApplyTransform(glm::vec3(corner, 1.0f), localTransform)));
+        glm::mat3 place(1.0f);
+        place[0][0] = scale.x;
+        place[1][1] = scale.y;
+        place[2] = glm::vec3(offset, 1.0f);
+        path->fillPaint.image = bitmap;
+        path->fillPaint.inverse = glm::inverse(box.Matrix() * localTransform * place);
+        path->fillColor = { 1.0f, 1.0f, 1.0f, state.totalOpacity };
+        path->strokeColor = glm::vec4(0.0f);
+        path->strokeWidth = 0.0f;
+        return path;
+    }
+
+    // first number of a coordinate list such as x="10 20 30"; per-glyph positioning is not supported
+    std::optional<float> FirstCoordinate(tinyxml2::XMLElement* elem, const char* name) {
+        const char* value = elem->Attribute(name);
+        if (!value) return std::nullopt;
+        char* end = nullptr;
+        float v = std::strtof(value, &end);
+        if (end == value) return std::nullopt;
+        return v;
+    }
+
+    // decodes the UTF-8 sequence at s[i] and advances i; malformed bytes decode as U+FFFD
+    int NextCodepoint(const std::string& s, size_t& i) {
+        unsigned char c = s[i++];
+        int length = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : -1;
+        if (length < 0) return 0xFFFD;
+        int codepoint = length == 0 ? c : c & (0x3F >> length);
+        for (int k = 0; k < length; k++) {
+            if (i >= s.size() or ((unsigned char)s[i] >> 6) != 0x2) return 0xFFFD;
+            codepoint = (codepoint << 6) | ((unsigned char)s[i++] & 0x3F);
+        }
+        return codepoint;
+    }
+
+    // Each glyph becomes a Use of its shared outline, placed at the pen position and scaled
+    // from outline units to the font size.
+    void SVGParser::ParseText(tinyxml2::XMLElement* elem, std::vector<Shape*>& shapes, const RenderStyle& state, const glm::mat3& localTransform) {
+        struct Glyph {
+            std::shared_ptr<const Definition> outline;
+            glm::vec2 pen;
+            RenderStyle style;
+        };
+        std::vector<Glyph> glyphs;
+        glm::vec2 pen = { FirstCoordinate(elem, "x").value_or(0.0f) + FirstCoordinate(elem, "dx").value_or(0.0f),
+                          FirstCoordinate(elem, "y").value_or(0.0f) + FirstCoordinate(elem, "dy").value_or(0.0f) };
+
+        // text chunks start at each absolute x and are aligned by the text-anchor of the element that started them
+        size_t chunk = 0;
+        float chunkStart = pen.x;
+        TextAnchor anchor = state.textAnchor;
+        auto finishChunk = [&]() {
+            float width = pen.x - chunkStart;
+            float shift = anchor == TextAnchor::Middle ? -width / 2.0f : anchor == TextAnchor::End ? -width : 0.0f;
+            for (size_t i = chunk; i < glyphs.size(); i++) glyphs[i].pen.x += shift;
+            chunk = glyphs.size();
+        };
+
+        // whitespace collapses to one space, which is only advanced over once something follows it
+        bool space = true;
+        float pendingSpace = 0.0f;
+        std::function<void(tinyxml2::XMLElement*, const RenderStyle&)> layout = [&](tinyxml2::XMLElement* parent, const RenderStyle& style) {
+            for (auto node = parent->FirstChild(); node; node = node->NextSibling()) {
+                if (auto text = node->ToText()) {
+                    const SVGFont* font = SVGFont::Get(style.fontFamily);
+                    if (!font or !text->Value()) continue;
+                    std::string value = text->Value();
+                    int previous = -1;
+                    for (size_t i = 0; i < value.size();) {
+                        int codepoint = NextCodepoint(value, i);
+                        if (codepoint == ' ' or codepoint == '\t' or codepoint == '\n' or codepoint == '\r') {
+                            if (!space) pendingSpace = font->GetAdvance(font->FindGlyph(' ')) * style.fontSize;
+                            space = true;
+                            previous = -1;
+                            continue;
+                        }
+                        space = false;
+                        int glyph = font->FindGlyph(codepoint);
+                        if (previous >= 0) pen.x += font->GetKerning(previous, glyph) * style.fontSize;
+                        pen.x += pendingSpace;
+                        pendingSpace = 0.0f;
+                        if (auto outline = font->GetOutline(glyph)) glyphs.push_back({ outline, pen, style });
+                        pen.x += font->GetAdvance(glyph) * style.fontSize;
+                        previous = glyph;
+                    }
+                } else if (auto child = node->ToElement(); child and std::string(child->Name()) == "tspan") {
+                    RenderStyle childStyle = InheritStyle(style, ParseStyle(child));
+                    auto x = FirstCoordinate(child, "x");
+                    if (x) {
+                        finishChunk();
+                        pen.x = *x;
+                        pendingSpace = 0.0f;
+                        anchor = childStyle.textAnchor;
+                    }
+                    if (auto y = FirstCoordinate(child, "y")) pen.y = *y;
+                    pen += glm::vec2(FirstCoordinate(child, "dx").value_or(0.0f), FirstCoordinate(child, "dy").value_or(0.0f));
+                    if (x) chunkStart = pen.x;
+                    layout(child, childStyle);
+                }
+            }
+        };
+        layout(elem, state);
+        finishChunk();
+        if (glyphs.empty()) return;
+
+        glm::mat3 toCanvas = box.Matrix() * localTransform;
+        auto placement = [&](const Glyph& g) {
+            float s = g.style.fontSize / SVGFont::EmUnits;
+            glm::mat3 place(s);
+            place[2] = glm::vec3(g.pen, 1.0f);
+            return toCanvas * place;
+        };
+
+        // objectBoundingBox paint servers use the bounds of the whole text element
+        Path bounds;
+        std::map<std::string, Paint> paints;
+        auto getPaint = [&](const std::string& id) {
+            if (bounds.sub_paths.empty()) {
+                glm::vec2 lo(1e30f), hi(-1e30f);
+                for (auto& g : glyphs) {
+                    glm::mat3 T = placement(g);
+                    for (auto& subpath : g.outline->entries[0].path->sub_paths)
+                        for (auto& p : subpath) {
+                            glm::vec2 q = glm::vec2(T * glm::vec3(p, 1.0f));
+                            lo = glm::min(lo, q);
+                            hi = glm::max(hi, q);
+                        }
+                }
+                bounds.sub_paths.push_back({ lo, { hi.x, lo.y }, hi, { lo.x, hi.y } });
+            }
+            auto it = paints.find(id);
+            if (it == paints.end()) it = paints.emplace(id, ResolvePaint(id, &bounds, toCanvas)).first;
+            return it->second;
+        };
+
+        for (auto& g : glyphs) {
+            Use* use = new Use();
+            use->definition = g.outline;
+            use->transform = placement(g);
+            use->style = g.style;
+            // StyleInstance scales stroke widths by the placement, which includes the font size
+            use->style.strokeWidth = g.style.strokeWidth * SVGFont::EmUnits / g.style.fontSize;
+            for (float& dash : use->style.dashArray) dash *= SVGFont::EmUnits / g.style.fontSize;
+            use->style.dashOffset *= SVGFont::EmUnits / g.style.fontSize;
+            use->clip = state.clip;
+            if (!g.style.fillPaint.empty() or !g.style.strokePaint.empty()) {
+                use->fillPaints.resize(1);
+                use->strokePaints.resize(1);
+                if (!g.style.fillPaint.empty()) {
+                    use->fillPaints[0] = getPaint(g.style.fillPaint);
+                    if (!use->fillPaints[0].gradient) use->style.fill.a = 0;
+                }
+                if (!g.style.strokePaint.empty()) {
+                    use->strokePaints[0] = getPaint(g.style.strokePaint);
+                    if (!use->strokePaints[0].gradient) use->style.stroke.a = 0;
+                }
+            }
+            shapes.push_back(use);
+        }
+    }
+
+    // x/y of the <use>, plus the viewBox -> width/height fit when it references a <symbol>
+    glm::mat3 UseOffset(tinyxml2::XMLElement* use, tinyxml2::XMLElement* target) {
+        glm::mat3 offset(1.0f);
+        offset[2][0] = use->FloatAttribute("x");
+        offset[2][1] = use->FloatAttribute("y");
+        const char* viewBoxstr = target->Attribute("viewBox");
+        if (std::string(target->Name()) != "symbol" or !viewBoxstr) return offset;
+
+        float minX = 0, minY = 0, width = 0, height = 0;
+        std::string asstring = viewBoxstr;
+        std::replace(asstring.begin(), asstring.end(), ',', ' ');
+        sscanf(asstring.c_str(), "%f %f %f %f", &minX, &minY, &width, &height);
+        float useWidth = use->FloatAttribute("width", width);
+        float useHeight = use->FloatAttribute("height", height);
+        if (width <= 0 or height <= 0 or useWidth <= 0 or useHeight <= 0) return offset;
+
+        // preserveAspectRatio="xMidYMid meet"
+        float scale = std::min(useWidth / width, useHeight / height);
+        glm::mat3 fit(scale);
+        fit[2][0] = (useWidth - width * scale) / 2.0f - minX * scale;
+        fit[2][1] = (useHeight - height * scale) / 2.0f - minY * scale;
+        fit[2][2] = 1.0f;
+        return offset * fit;
+    }
+
+    Use* SVGParser::ParseUse(tinyxml2::XMLElement* elem, const RenderStyle& state, const glm::mat3& localTransform, float transformScale) {
+        const char* id = GetHref(elem);
+        if (!id) return nullptr;
+        auto it = g_Elements.find(id);
+        if (it == g_Elements.end()) {
+            std::cerr << "Warning: <use> references unknown id:" << id << std::endl;
+            return nullptr;
+        }
+        glm::mat3 instanceTransform = localTransform * UseOffset(elem, it->second);
+        float instanceScale = std::sqrt(std::abs(glm::determinant(instanceTransform)));
+        auto definition = GetDefinition(id, box.scale * instanceScale);
+        if (!definition or definition->entries.empty()) return nullptr;
+
+        Use* use = new Use();
+        use->definition = definition;
+        glm::mat3 unscale(1.0f / definition->scale);
+        unscale[2][2] = 1.0f;
+        use->transform = box.Matrix() * instanceTransform * unscale;
+
+        // paint servers are resolved per entry against the shared geometry
+        glm::mat3 canvasToDefinition = glm::inverse(use->transform);
+        for (int i = 0; i < definition->entries.size(); i++) {
+            auto& entry = definition->entries[i];
+            std::string fillPaint = entry.style.fillPaint.value_or(state.fillPaint);
+            std::string strokePaint = entry.style.strokePaint.value_or(state.strokePaint);
+            if (fillPaint.empty() and strokePaint.empty()) continue;
+            use->fillPaints.resize(definition->entries.size());
+            use->strokePaints.resize(definition->entries.size());
+            if (!fillPaint.empty()) {
+                use->fillPaints[i] = ResolvePaint(fillPaint, entry.path, entry.transform);
+                use->fillPaints[i].inverse = use->fillPaints[i].inverse * canvasToDefinition;
+            }
+            if (!strokePaint.empty()) {
+                use->strokePaints[i] = ResolvePaint(strokePaint, entry.path, entry.transform);
+                use->strokePaints[i].inverse = use->strokePaints[i].inverse * canvasToDefinition;
+            }
+        }
+        return use;
+    }
+
+    std::shared_ptr<Definition> SVGParser::GetDefinition(const std::string& id, float scale) {
+        // instances within a power of two of each other share one flattening, made at the top of their bucket
+        // so that none of them shows facets
+        int bucket = (int)std::ceil(std::log2(std::max(scale, 1e-6f)));
+        auto cached = g_Definitions.find({ id, bucket });
+        if (cached != g_Definitions.end()) return cached->second;
+
+        auto definition = std::make_shared<Definition>();
+        definition->id = id;
+        definition->scale = scale = std::ldexp(1.0f, bucket);
+        ViewBox saved = box;
+        box.scale = scale;
+        box.offsetX = box.offsetY = 0.0f;
+        ParseDefinition(g_Elements[id], *definition, {}, glm::mat3(1.0f), 0);
+        box = saved;
+        g_Definitions[{ id, bucket }] = definition;
+        return definition;
+    }
+
+    void SVGParser::ParseDefinition(tinyxml2::XMLElement* elem, Definition& definition, const ShapeStyle& parent, const glm::mat3& parentTransform, int depth, bool referenced) {
+        if (!elem or depth > 16) return;
+        std::string name = elem->Name();
+        if (depth > 0 and !referenced and (name == "defs" or name == "symbol")) return;
+        if (depth > 0 and (name == "linearGradient" or name == "radialGradient" or name == "clipPath" or name == "filter")) return;
+
+        auto style = MergeStyle(parent, ParseStyle(elem));
+        glm::mat3 localTransform = parentTransform * ParseTransformAttribute(elem);
+        float transformScale = std::sqrt(std::abs(glm::determinant(localTransform)));
+
+        if (name == "use") {
+            // nested instances are expanded into the enclosing definition
+            const char* id = GetHref(elem);
+            auto it = id ? g_Elements.find(id) : g_Elements.end();
+            if (it != g_Elements.end())
+                ParseDefinition(it->second, definition, style, localTransform * UseOffset(elem, it->second), depth + 1, true);
+            return;
+        }
+
+        if (Path* path = ParseGeometry(elem, localTransform, transformScale))
+            definition.entries.push_back({ path, style, box.Matrix() * localTransform });
+
+        tinyxml2::XMLElement* child = elem->FirstChildElement();
+        while (child) {
+            ParseDefinition(child, definition, style, localTransform, depth + 1);
+            child = child->NextSiblingElement();
+        }
+    }
+
+    // number or percentage; percentages are relative to `base`
+    float ParseCoordinate(const char* value, float fallback, float base) {
+        if (!value) return fallback;
+        char* end = nullptr;
+        float v = std::strtof(value, &end);
+        if (end == value) return fallback;
+        while (*end and std::isspace((unsigned char)*end)) end++;
+        return *end == '%' ? v / 100.0f * base : v;
+    }
+
+    void BuildGradientLut(Gradient& gradient) {
+        auto& stops = gradient.stops;
+        gradient.lut.resize(Gradient::LutSize);
+        for (int i = 0; i < Gradient::LutSize; i++) {
+            float t = i / (float)(Gradient::LutSize - 1);
+            if (stops.empty()) {
+                gradient.lut[i] = {0, 0, 0, 0};
+                continue;
+            }
+            int k = 0;
+            while (k < stops.size() and stops[k].first <= t) k++;
+            if (k == 0) gradient.lut[i] = stops.front().second;
+            else if (k == stops.size()) gradient.lut[i] = stops.back().second;
+            else {
+                auto& [t0, c0] = stops[k - 1];
+                auto& [t1, c1] = stops[k];
+                float w = t1 - t0 > 1e-6f ? (t - t0) / (t1 - t0) : 1.0f;
+                gradient.lut[i] = c0 * (1.0f - w) + c1 * w;
+            }
+        }
+    }
+
+    std::shared_ptr<Gradient> SVGParser::GetGradient(const std::string& id) {
+        auto cached = g_Gradients.find(id);
+        if (cached != g_Gradients.end()) return cached->second;
+        auto it = g_Elements.find(id);
+        if (it == g_Elements.end()) {
+            std::cerr << "Warning: unknown paint server:" << id << std::endl;
+            return g_Gradients[id] = nullptr;
+        }
+        std::string name = it->second->Name();
+        if (name != "linearGradient" and name != "radialGradient") {
+            std::cerr << "Warning: unsupported paint server:" << name << std::endl;
+            return g_Gradients[id] = nullptr;
+        }
+
+        // attributes and stops not given on a gradient are inherited through href
+        std::vector<tinyxml2::XMLElement*> chain;
+        for (auto e = it->second; e and chain.size() < 16; ) {
+            chain.push_back(e);
+            auto href = GetHref(e);
+            auto next = href ? g_Elements.find(href) : g_Elements.end();
+            e = next != g_Elements.end() ? next->second : nullptr;
+        }
+        auto attribute = [&](const char* key) -> const char* {
+            for (auto e : chain)
+                if (auto v = e->Attribute(key)) return v;
+            return nullptr;
+        };
+
+        auto gradient = std::make_shared<Gradient>();
+        gradient->type = name == "radialGradient" ? GradientType::Radial : GradientType::Linear;
+        if (auto units = attribute("gradientUnits"))
+            gradient->objectBoundingBox = std::string(units) != "userSpaceOnUse";
+        if (auto spread = attribute("spreadMethod")) {
+            if (std::string(spread) == "reflect") gradient->spread = SpreadMethod::Reflect;
+            else if (std::string(spread) == "repeat") gradient->spread = SpreadMethod::Repeat;
+        }
+        if (auto transformstr = attribute("gradientTransform")) {
+            std::string transforms = transformstr;
+            for (char& c : transforms) {
+                if (c == '(' or c == ')' or c == ',') c = ' ';
+            }
+            ParseTransform(transforms, gradient->transform);
+        }
+
+        float w = gradient->objectBoundingBox ? 1.0f : box.width;
+        float h = gradient->objectBoundingBox ? 1.0f : box.height;
+        float d = gradient->objectBoundingBox ? 1.0f : std::sqrt((w * w + h * h) / 2.0f);
+        if (gradient->type == GradientType::Linear) {
+            gradient->p1 = { ParseCoordinate(attribute("x1"), 0, w), ParseCoordinate(attribute("y1"), 0, h) };
+            gradient->p2 = { ParseCoordinate(attribute("x2"), w, w), ParseCoordinate(attribute("y2"), 0, h) };
+        } else {
+            gradient->center = { ParseCoordinate(attribute("cx"), 0.5f * w, w), ParseCoordinate(attribute("cy"), 0.5f * h, h) };
+            gradient->radius = ParseCoordinate(attribute("r"), 0.5f * d, d);
+            gradient->focus = { ParseCoordinate(attribute("fx"), gradient->center.x, w), ParseCoordinate(attribute("fy"), gradient->center.y, h) };
+            // SVG 1.1: a focal point outside the circle is moved onto it
+            glm::vec2 offset = gradient->focus - gradient->center;
+            float limit = gradient->radius * 0.999f;
+            if (glm::length(offset) > limit) gradient->focus = gradient->center + offset * (limit / glm::length(offset));
+        }
+
+        for (auto e : chain) {
+            if (!e->FirstChildElement("stop")) continue;
+            for (auto stop = e->FirstChildElement("stop"); stop; stop = stop->NextSiblingElement("stop")) {
+                float offset = std::clamp(ParseCoordinate(stop->Attribute("offset"), 0, 1), 0.0f, 1.0f);
+                if (!gradient->stops.empty()) offset = std::max(offset, gradient->stops.back().first);
+                glm::vec4 color = ParseColor(stop->Attribute("stop-color"));
+                float opacity = stop->FloatAttribute("stop-opacity", 1.0f);
+                if (auto stylestr = stop->Attribute("style")) {
+                    std::stringstream ss(stylestr);
+                    std::string item;
+                    while (std::getline(ss, item, ';')) {
+                        size_t colonPos = item.find(':');
+                        if (colonPos == std::string::npos) continue;
+                        std::string key = Trim(item.substr(0, colonPos));
+                        std::string val = Trim(item.substr(colonPos + 1));
+                        if (key == "stop-color") color = ParseColor(val.c_str());
+                        else if (key == "stop-opacity") opacity = std::stof(val);
+                    }
+                }
+                color.a *= opacity;
+                gradient->stops.push_back({ offset, color });
+            }
+            break;
+        }
+        BuildGradientLut(*gradient);
+        return g_Gradients[id] = gradient;
+    }
+
+    Paint SVGParser::ResolvePaint(const std::string& id, const Path* path, const glm::mat3& userToCanvas) {
+        Paint paint;
+        auto gradient = GetGradient(id);
+        if (!gradient) return paint;
+
+        glm::mat3 units(1.0f);
+        if (gradient->objectBoundingBox) {
+            // bounding box of the element in its own user space
+            glm::mat3 toUser = glm::inverse(userToCanvas);
+            glm::vec2 lo(1e30f), hi(-1e30f);
+            for (auto& subpath : path->sub_paths)
+                for (auto& p : subpath) {
+                    glm::vec2 q = ApplyTransform(glm::vec3(p, 1.0f), toUser);
+                    lo = glm::min(lo, q);
+                    hi = glm::max(hi, q);
+                }
+            if (hi.x - lo.x < 1e-6f or hi.y - lo.y < 1e-6f) return paint;
+            units[0][0] = hi.x - lo.x;
+            units[1][1] = hi.y - lo.y;
+            units[2][0] = lo.x;
+            units[2][1] = lo.y;
+        }
+        paint.gradient = gradient;
+        paint.inverse = glm::inverse(userToCanvas * units * gradient->transform);
+        return paint;
+    }
+
+    std::shared_ptr<const ClipPath> SVGParser::ResolveClip(const std::string& id, const glm::mat3& localTransform, const Path* bboxPath, std::shared_ptr<const ClipPath> parent, int depth) {
+        auto it = g_Elements.find(id);
+        if (it == g_Elements.end() or std::string(it->second->Name()) != "clipPath" or depth > 16) {
+            std::cerr << "Warning: unknown clip path:" << id << std::endl;
+            return parent;
+        }
+        tinyxml2::XMLElement* clipElem = it->second;
+
+        glm::mat3 clipTransform = localTransform;
+        auto units = clipElem->Attribute("clipPathUnits");
+        bool boundingBox = units and std::string(units) == "objectBoundingBox";
+        if (boundingBox and !bboxPath) {
+            std::cerr << "Warning: objectBoundingBox clip path on a group is not supported:" << id << std::endl;
+            boundingBox = false;
+        }
+        if (boundingBox) {
+            glm::mat3 toUser = glm::inverse(box.Matrix() * localTransform);
+            glm::vec2 lo(1e30f), hi(-1e30f);
+            for (auto& subpath : bboxPath->sub_paths)
+                for (auto& p : subpath) {
+                    glm::vec2 q = ApplyTransform(glm::vec3(p, 1.0f), toUser);
+                    lo = glm::min(lo, q);
+                    hi = glm::max(hi, q);
+                }
+            glm::mat3 bbox(1.0f);
+            if (lo.x <= hi.x) {
+                bbox[0][0] = hi.x - lo.x;
+                bbox[1][1] = hi.y - lo.y;
+                bbox[2][0] = lo.x;
+                bbox[2][1] = lo.y;
+            }
+            clipTransform = clipTransform * bbox;
+        }
+        clipTransform = clipTransform * ParseTransformAttribute(clipElem);
+
+        // shapes that reference the same clip from the same user space share one ClipPath, so it is rasterized once;
+        // only within one element with an id, since editing that element moves its clips
+        std::array<float, 6> key = { clipTransform[0][0], clipTransform[0][1], clipTransform[1][0], clipTransform[1][1], clipTransform[2][0], clipTransform[2][1] };
+        auto cacheKey = std::make_tuple(id, key, parent.get(), g_Enclosing);
+        if (!boundingBox) {
+            auto cached = g_Clips.find(cacheKey);
+            if (cached != g_Clips.end()) return cached->second;
+        }
+
+        // a clip-path on the <clipPath> itself intersects as well
+        std::string own = ParseUrl(GetProperty(clipElem, "clip-path"));
+        auto clip = std::make_shared<ClipPath>();
+        clip->element = g_Enclosing;
+        clip->parent = own.empty() ? parent : ResolveClip(own, localTransform, bboxPath, parent, depth + 1);
+
+        std::string clipRule = GetProperty(clipElem, "clip-rule");
+        for (auto child = clipElem->FirstChildElement(); child; child = child->NextSiblingElement()) {
+            tinyxml2::XMLElement* target = child;
+            glm::mat3 childTransform = clipTransform * ParseTransformAttribute(child);
+            if (std::string(child->Name()) == "use") {
+                const char* href = GetHref(child);
+                auto ref = href ? g_Elements.find(href) : g_Elements.end();
+                if (ref == g_Elements.end()) continue;
+                target = ref->second;
+                childTransform = childTransform * UseOffset(child, target) * ParseTransformAttribute(target);
+            }
+            float transformScale = std::sqrt(std::abs(glm::determinant(childTransform)));
+            Path* path = ParseGeometry(target, childTransform, transformScale);
+            if (!path) continue;
+            std::string rule = GetProperty(child, "clip-rule");
+            if (rule.empty()) rule = GetProperty(target, "clip-rule");
+            if (rule.empty()) rule = clipRule;
+            path->fill_rule = rule == "evenodd" ? FillRule::EvenOdd : FillRule::NonZero;
+            clip->paths.push_back(path);
+        }
+
+        if (!boundingBox) g_Clips[cacheKey] = clip;
+        return clip;
+    }
+
+    std::shared_ptr<const Filter> SVGParser::ResolveFilter(const std::string& id, const glm::mat3& localTransform, const glm::vec4& bounds) {
+        auto it = g_Elements.find(id);
+        if (it == g_Elements.end() or std::string(it->second->Name()) != "filter") {
+            std::cerr << "Warning: unknown filter:" << id << std::endl;
+            return nullptr;
+        }
+        tinyxml2::XMLElement* filterElem = it->second;
+        glm::mat3 toCanvas = box.Matrix() * localTransform;
+        glm::vec2 axisScale = { glm::length(glm::vec2(toCanvas[0])), glm::length(glm::vec2(toCanvas[1])) };
+
+        // filter region, -10% / 120% of the bounding box by default
+        glm::mat3 toUser = glm::inverse(toCanvas);
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        for (int k = 0; k < 4; k++) {
+            glm::vec2 q = glm::vec2(toUser * glm::vec3(k & 1 ? bounds.z : bounds.x, k & 2 ? bounds.w : bounds.y, 1.0f));
+            lo = glm::min(lo, q);
+            hi = glm::max(hi, q);
+        }
+        glm::vec2 size = hi - lo;
+        float x = lo.x - 0.1f * size.x, y = lo.y - 0.1f * size.y, w = 1.2f * size.x, h = 1.2f * size.y;
+        auto units = filterElem->Attribute("filterUnits");
+        if (units and std::string(units) == "userSpaceOnUse") {
+            x = ParseCoordinate(filterElem->Attribute("x"), x, 0.0f);
+            y = ParseCoordinate(filterElem->Attribute("y"), y, 0.0f);
+            w = ParseCoordinate(filterElem->Attribute("width"), w, 0.0f);
+            h = ParseCoordinate(filterElem->Attribute("height"), h, 0.0f);
+        } else {
+            x = lo.x + size.x * ParseCoordinate(filterElem->Attribute("x"), -0.1f, 1.0f);
+            y = lo.y + size.y * ParseCoordinate(filterElem->Attribute("y"), -0.1f, 1.0f);
+            w = size.x * ParseCoordinate(filterElem->Attribute("width"), 1.2f, 1.0f);
+            h = size.y * ParseCoordinate(filterElem->Attribute("height"), 1.2f, 1.0f);
+        }
+        auto primitiveUnits = filterElem->Attribute("primitiveUnits");
+        if (primitiveUnits and std::string(primitiveUnits) == "objectBoundingBox")
+            std::cerr << "Warning: primitiveUnits=objectBoundingBox is not supported:" << id << std::endl;
+
+        auto filter = std::make_shared<Filter>();
+        lo = glm::vec2(1e30f);
+        hi = glm::vec2(-1e30f);
+        for (int k = 0; k < 4; k++) {
+            glm::vec2 q = glm::vec2(toCanvas * glm::vec3(k & 1 ? x + w : x, k & 2 ? y + h : y, 1.0f));
+            lo = glm::min(lo, q);
+            hi = glm::max(hi, q);
+        }
+        filter->region = { lo.x, lo.y, hi.x, hi.y };
+
+        for (auto child = filterElem->FirstChildElement(); child; child = child->NextSiblingElement()) {
+            std::string kind = child->Name();
+            FilterPrimitive primitive;
+            if (kind == "feGaussianBlur") {
+                primitive.kind = FilterKind::GaussianBlur;
+                float sx = 0, sy = -1;
+                if (auto value = child->Attribute("stdDeviation")) {
+                    std::string asstring = value;
+                    std::replace(asstring.begin(), asstring.end(), ',', ' ');
+                    sscanf(asstring.c_str(), "%f %f", &sx, &sy);
+                }
+                if (sy < 0) sy = sx;
+                primitive.stdDeviation = glm::max(glm::vec2(sx, sy), glm::vec2(0.0f)) * axisScale;
+            } else if (kind == "feOffset") {
+                primitive.kind = FilterKind::Offset;
+                primitive.offset = glm::vec2(toCanvas * glm::vec3(child->FloatAttribute("dx"), child->FloatAttribute("dy"), 0.0f));
+            } else if (kind == "feFlood") {
+                primitive.kind = FilterKind::Flood;
+                std::string color = GetProperty(child, "flood-color");
+                std::string opacity = GetProperty(child, "flood-opacity");
+                primitive.flood = color.empty() ? glm::vec4(0, 0, 0, 1) : ParseColor(color.c_str());
+                if (!opacity.empty()) primitive.flood.a *= std::clamp(std::stof(opacity), 0.0f, 1.0f);
+            } else if (kind == "feMerge") {
+                primitive.kind = FilterKind::Merge;
+                for (auto node = child->FirstChildElement("feMergeNode"); node; node = node->NextSiblingElement("feMergeNode"))
+                    primitive.in.push_back(node->Attribute("in") ? node->Attribute("in") : "");
+            } else {
+                std::cerr << "Warning: unsupported filter primitive:" << kind << std::endl;
+                continue;
+            }
+            if (primitive.kind != FilterKind::Merge) primitive.in.push_back(child->Attribute("in") ? child->Attribute("in") : "");
+            if (auto result = child->Attribute("result")) primitive.result = result;
+            filter->primitives.push_back(primitive);
+        }
+        return filter;
+    }
+
+    void CollectIds(tinyxml2::XMLElement* elem) {
+        for (; elem; elem = elem->NextSiblingElement()) {
+            if (auto id = elem->Attribute("id")) g_Elements.emplace(id, elem);
+            CollectIds(elem->FirstChildElement());
+        }
     }
 
     #ifdef _WIN32
@@ -793,10 +1679,7 @@ namespace VCX::Labs::GettingStarted {
     }
     #endif
 
-    std::vector<Shape*> SVGParser::ParseFile(const std::string& filename, int samplerate) {
-        std::vector<Shape*> shapes;
-        tinyxml2::XMLDocument doc;
-
+    bool SVGParser::LoadDocument(const std::string& filename, tinyxml2::XMLDocument& doc) {
         tinyxml2::XMLError error;
 
         #ifdef _WIN32
@@ -804,7 +1687,7 @@ namespace VCX::Labs::GettingStarted {
             FILE* fp = _wfopen(wfilename.c_str(), L"rb");
             if (!fp) {
                 std::cerr << "Failed to load SVG file: " << filename << std::endl;
-                return shapes;
+                return false;
             }
             error = doc.LoadFile(fp);
             fclose(fp);
@@ -814,12 +1697,19 @@ namespace VCX::Labs::GettingStarted {
 
         if (error != tinyxml2::XML_SUCCESS) {
             std::cerr << "Failed to load SVG file: " << filename << std::endl;
-            return shapes;
+            return false;
         }
+        return true;
+    }
 
-        tinyxml2::XMLElement* root = doc.RootElement(); // <svg>
-        if (!root) return shapes;
-    
+    std::vector<Shape*> SVGParser::ParseFile(const std::string& filename, int samplerate, glm::mat3* userToCanvas) {
+        tinyxml2::XMLDocument doc;
+        if (!LoadDocument(filename, doc)) return {};
+        return ParseDocument(doc, filename, samplerate, userToCanvas);
+    }
+
+    // lays the root viewBox out on the canvas of `samplerate` x (width, height) into the global `box`
+    void LayoutViewBox(tinyxml2::XMLElement* root, int samplerate) {
         const char* ViewBoxstr = root->Attribute("viewBox");
         box = ViewBox();
         box.scale = 1.0f, box.offsetX = box.offsetY = 0.0f;
@@ -834,39 +1724,58 @@ namespace VCX::Labs::GettingStarted {
         float canvasHeight = root->IntAttribute("height", 600);
         canvasWidth /= 1.1, canvasHeight /= 1.1;
         box.ComputeScale(canvasWidth * samplerate, canvasHeight * samplerate, 0.9);
+    }
+
+    std::vector<Shape*> SVGParser::ParseDocument(tinyxml2::XMLDocument& doc, const std::string& filename, int samplerate, glm::mat3* userToCanvas, std::vector<ElementId>* elements) {
+        std::vector<Shape*> shapes;
+        tinyxml2::XMLElement* root = doc.RootElement(); // <svg>
+        if (!root) return shapes;
+
+        LayoutViewBox(root, samplerate);
+        if (userToCanvas) *userToCanvas = box.Matrix();
+        g_Elements.clear();
+        g_Definitions.clear();
+        g_Gradients.clear();
+        g_Clips.clear();
+        g_Directory = std::filesystem::path(filename).parent_path().string();
+        CollectIds(root);
+        g_Ids.clear();
+        g_Enclosing = -1;
         ParseElement(root, shapes, {}, glm::mat3(1.0f));
+        if (elements) *elements = std::move(g_Ids);
+        g_Ids.clear();
+        g_Elements.clear();
+        g_Definitions.clear();
+        g_Gradients.clear();
+        g_Clips.clear();
 
         return shapes;
     }
 
     std::pair<int, int> SVGParser::GetSceneSize(const std::string& filename) {
         tinyxml2::XMLDocument doc;
-        int x, y;
-        tinyxml2::XMLError error;
-
-        #ifdef _WIN32
-            std::wstring wfilename = Utf8ToWstring(filename);
-            FILE* fp = _wfopen(wfilename.c_str(), L"rb");
-            if (!fp) {
-                std::cerr << "Failed to load SVG file: " << filename << std::endl;
-                return {-1, -1};
-            }
-            error = doc.LoadFile(fp);
-            fclose(fp);
-        #else
-            error = doc.LoadFile(filename.c_str());
-        #endif
+        if (!LoadDocument(filename, doc)) return {-1, -1};
+        return GetSceneSize(doc);
+    }
 
-        if (error != tinyxml2::XML_SUCCESS) {
-            std::cerr << "Failed to load SVG file: " << filename << std::endl;
-            return {-1, -1};
-        }
+    glm::vec4 SVGParser::GetViewBox(tinyxml2::XMLDocument& doc, glm::mat3* userToCanvas) {
+        tinyxml2::XMLElement* root = doc.RootElement();
+        if (!root) return glm::vec4(0, 0, 800, 600);
+        ViewBox saved = box;
+        LayoutViewBox(root, 1);
+        glm::vec4 viewBox(box.minX, box.minY, box.width, box.height);
+        if (userToCanvas) *userToCanvas = box.Matrix();
+        box = saved;
+        return viewBox;
+    }
 
+    std::pair<int, int> SVGParser::GetSceneSize(tinyxml2::XMLDocument& doc) {
         tinyxml2::XMLElement* root = doc.RootElement();
+        if (!root) return {-1, -1};
         std::string name = root->Name();
         if (name == "svg") {
-            x = root->IntAttribute("width", -1);
-            y = root->IntAttribute("height", -1);
+            int x = root->IntAttribute("width", -1);
+            int y = root->IntAttribute("height", -1);
             return {x, y};
         }
         else return {-1, -1};
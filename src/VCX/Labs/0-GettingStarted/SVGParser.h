@@ -8,14 +8,33 @@
 namespace VCX::Labs::GettingStarted {
     class SVGParser {
     public:
-        static std::vector<Shape*> ParseFile(const std::string& filename, int samplerate);
+        // `userToCanvas`, when given, receives the root viewBox mapping the shapes were flattened with
+        static std::vector<Shape*> ParseFile(const std::string& filename, int samplerate, glm::mat3* userToCanvas = nullptr);
         static std::pair<int, int> GetSceneSize(const std::string& filename);
+        // split form of ParseFile, for flattening one loaded document at several sample rates
+        static bool LoadDocument(const std::string& filename, tinyxml2::XMLDocument& doc);
+        // `elements`, when given, receives every rendered element with an id, indexed by Shape::element
+        static std::vector<Shape*> ParseDocument(tinyxml2::XMLDocument& doc, const std::string& filename, int samplerate, glm::mat3* userToCanvas = nullptr, std::vector<ElementId>* elements = nullptr);
+        static std::pair<int, int> GetSceneSize(tinyxml2::XMLDocument& doc);
+        // root viewBox (x, y, width, height) in user units and its mapping onto the canvas at sample rate 1
+        static glm::vec4 GetViewBox(tinyxml2::XMLDocument& doc, glm::mat3* userToCanvas = nullptr);
     
     private:
         static glm::vec4 ParseColor(const char* hexString);
         static ShapeStyle ParseStyle(tinyxml2::XMLElement* elem);
         static void ParseStyleAttribute(const char* styleStr, ShapeStyle& style);
         static void ParseElement(tinyxml2::XMLElement* elem, std::vector<Shape*>& shapes, const RenderStyle& parent, const glm::mat3& parentTransform);
+        static Path* ParseGeometry(tinyxml2::XMLElement* elem, const glm::mat3& localTransform, float transformScale);
+        static Path* ParseImage(tinyxml2::XMLElement* elem, const RenderStyle& state, const glm::mat3& localTransform);
+        static void ParseText(tinyxml2::XMLElement* elem, std::vector<Shape*>& shapes, const RenderStyle& state, const glm::mat3& localTransform);
+        static Use* ParseUse(tinyxml2::XMLElement* elem, const RenderStyle& state, const glm::mat3& localTransform, float transformScale);
+        static std::shared_ptr<Definition> GetDefinition(const std::string& id, float scale);
+        static std::shared_ptr<Gradient> GetGradient(const std::string& id);
+        static Paint ResolvePaint(const std::string& id, const Path* path, const glm::mat3& userToCanvas);
+        static std::shared_ptr<const Filter> ResolveFilter(const std::string& id, const glm::mat3& localTransform, const glm::vec4& bounds);
+        static std::shared_ptr<const ClipPath> ResolveClip(const std::string& id, const glm::mat3& localTransform, const Path* bboxPath, std::shared_ptr<const ClipPath> parent, int depth);
+        // `referenced`: `elem` is the target of a nested <use>, so a <symbol> or <defs> there is instanced, not skipped
+        static void ParseDefinition(tinyxml2::XMLElement* elem, Definition& definition, const ShapeStyle& parent, const glm::mat3& parentTransform, int depth, bool referenced = false);
         static void ParsePath(Path* path, const std::string& d, const glm::mat3& transform, float transformscale);
     };
 }
@@ -1,17 +1,52 @@
 #include "SVGRasterizer.h"
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <iostream>
 #include <map>
+#include "SVGFont.h"
+#include "Engine/Parallel.hpp"
+#include "Engine/loader.h"
 
 namespace VCX::Labs::GettingStarted {
     void SVGRasterizer::Rasterize(Common::ImageRGB& image, const std::vector<Shape*>& shapes) {
-        for (int x = 0; x < image.GetSizeX(); x++)
-            for (int y = 0; y < image.GetSizeY(); y++)
-                image.At(x, y) = {1.0f, 1.0f, 1.0f}; 
+        image.Fill({1.0f, 1.0f, 1.0f});
+        bool sampled = !_sampleOffsets.empty();
+        if (sampled) {
+            _coverage.assign(image.GetSizeX() * image.GetSizeY(), 0);
+            _coverageWidth = image.GetSizeX();
+            _covered = { image.GetSizeX(), image.GetSizeY(), 0, 0 };
+        }
 
+        // masks only pay off for entries instanced more than once at the same scale/rotation;
+        // they hold one sample per pixel, so multi-sampling draws every instance itself
+        _masks.clear();
+        _maskUses.clear();
         for (auto shape : shapes) {
-            if (shape->type == ShapeType::Rectangle) 
+            if (shape->type != ShapeType::Use or sampled) continue;
+            Use* use = static_cast<Use*>(shape);
+            // a mask bigger than the target (deep zoom) costs more than drawing the instance clipped to it
+            glm::vec4 bounds = GetBounds(use);
+            if ((bounds.z - bounds.x) * (bounds.w - bounds.y) > (float)image.GetSizeX() * image.GetSizeY()) continue;
+            for (int i = 0; i < use->definition->entries.size(); i++)
+                _maskUses[GetMaskKey(use, i, StyleInstance(use, i))]++;
+        }
+
+        for (int index = 0; index < shapes.size(); index++) {
+            Shape* shape = shapes[index];
+            if (sampled and shape->type != ShapeType::LayerBegin and shape->type != ShapeType::LayerEnd) {
+                DrawSampled(image, shape);
+                continue;
+            }
+            _clip = shape->clip ? &GetClipMask(shape->clip.get(), image.GetSizeX(), image.GetSizeY()) : nullptr;
+            if (shape->type == ShapeType::LayerBegin)
+                BeginLayer(image, shapes, index);
+            else if (shape->type == ShapeType::LayerEnd)
+                EndLayer(image);
+            // an empty clip hides a drawing op, but layers still open and close around it
+            else if (_clip and _clip->y0 >= _clip->y1)
+                continue;
+            else if (shape->type == ShapeType::Rectangle) 
                 DrawRect(image, static_cast<Rect*>(shape));
             else if (shape->type == ShapeType::Circle) 
                 DrawCircle(image, static_cast<Circle*>(shape));
@@ -19,7 +54,14 @@ namespace VCX::Labs::GettingStarted {
                 DrawEllipse(image, static_cast<Ellipse*>(shape));
             else if (shape->type == ShapeType::Path) 
                 DrawPath(image, static_cast<Path*>(shape));
+            else if (shape->type == ShapeType::Use)
+                DrawUse(image, static_cast<Use*>(shape));
         }
+        while (!_layers.empty()) EndLayer(image);
+        _surface = -1;
+        _clip = nullptr;
+        _masks.clear();
+        _clipMasks.clear();
     }
 
     void SVGRasterizer::Supersample(
@@ -30,21 +72,94 @@ namespace VCX::Labs::GettingStarted {
         int oX = output.GetSizeX(), oY = output.GetSizeY();
         int iX = input.GetSizeX(), iY = input.GetSizeY();
         float r = 1.0 * iX / oX / rate;
-        for (int i = 0; i < oX; i++) {
-            for (int j = 0; j < oY; j++) {
+        // source rows are decoded and the output row encoded a whole row at a time
+        std::vector<glm::vec3> decoded(std::size_t(rate) * iX), resolved(oX);
+        std::vector<const glm::vec3*> rows(rate);
+        // sample columns are the same for every row; -1 past the input
+        std::vector<int> columns(std::size_t(oX) * rate);
+        for (int i = 0; i < oX; i++)
+            for (int k = 0; k < rate; k++) {
+                int nx = i * r * rate + r * k;
+                columns[i * rate + k] = nx < iX ? nx : -1;
+            }
+        for (int j = 0; j < oY; j++) {
+            for (int l = 0; l < rate; l++) {
+                int ny = j * r * rate + r * l;
+                rows[l] = nullptr;
+                if (ny >= iY) continue;
+                auto row = decoded.data() + std::size_t(l) * iX;
+                Engine::Formats::RGB8::DecodeRow({ input.Row(ny), std::size_t(iX) }, { row, std::size_t(iX) });
+                rows[l] = row;
+            }
+            for (int i = 0; i < oX; i++) {
                 glm::vec3 color(0);
-                for (int k = 0; k < rate; k++) 
-                  for (int l = 0; l < rate; l++) {
-                    int nx = i * r * rate + r * k, ny = j * r * rate + r * l;
-                    if (nx < iX and ny < iY) {
-                        color += glm::vec3(input.At(nx, ny));
-                    }
-                  }
-                output.At(i, j) = color / (float)rate / (float)rate;
+                const int* column = columns.data() + i * rate;
+                for (int k = 0; k < rate; k++) {
+                    int nx = column[k];
+                    if (nx < 0) continue;
+                    for (int l = 0; l < rate; l++)
+                        if (rows[l]) color += rows[l][nx];
+                }
+                resolved[i] = color / (float)rate / (float)rate;
             }
+            Engine::Formats::RGB8::EncodeRow(resolved, { output.Row(j), std::size_t(oX) });
         }
     }
     
+    void SVGRasterizer::SetSamples(int samples) {
+        _samples = samples <= 1 ? 1 : std::min(32, (int)std::bit_ceil(unsigned(samples)));
+        // n-rooks: one sample per row and per column of an n x n grid, the columns stepped by a stride
+        // coprime to n so the samples also form an even lattice; 4 has none better than a diagonal and
+        // takes the rotated grid instead
+        static constexpr int RotatedGrid[4] = { 1, 3, 0, 2 };
+        int stride = _samples <= 2 ? 1 : _samples == 8 ? 3 : _samples == 16 ? 5 : 9;
+        _sampleOffsets.clear();
+        for (int i = 0; i < _samples and _samples > 1; i++) {
+            int column = _samples == 4 ? RotatedGrid[i] : i * stride % _samples;
+            _sampleOffsets.push_back({ (column + 0.5f) / _samples, (i + 0.5f) / _samples });
+        }
+    }
+
+    void SVGRasterizer::SetSampleOffset(glm::vec2 offset) {
+        _samples = 1;
+        _sampleOffsets.assign(1, glm::clamp(offset, 0.0f, 0.999f));
+    }
+
+    // the bundled blue-noise tile, row-major in [0, 1]; empty when it is missing or not NoiseTile square.
+    // Loaded once, so a missing tile is reported once
+    static const std::vector<float>& BlueNoise() {
+        static const std::vector<float> noise = [] {
+            auto tile = Engine::LoadImageGray(Engine::ResolveAsset("assets/images/bluenoise-256x256.png"));
+            std::vector<float> values;
+            if (tile.GetSizeX() != SVGRasterizer::NoiseTile or tile.GetSizeY() != SVGRasterizer::NoiseTile) {
+                std::cerr << "Warning: blue-noise tile not found, jittered sampling stays on the regular pattern" << std::endl;
+                return values;
+            }
+            values.reserve(SVGRasterizer::NoiseTile * SVGRasterizer::NoiseTile);
+            for (int y = 0; y < SVGRasterizer::NoiseTile; y++)
+                for (int x = 0; x < SVGRasterizer::NoiseTile; x++) values.push_back(tile.At(x, y));
+            return values;
+        }();
+        return noise;
+    }
+
+    void SVGRasterizer::SetJitter(bool jitter, glm::ivec2 origin) {
+        _noise = jitter and !BlueNoise().empty() ? BlueNoise().data() : nullptr;
+        _noiseOrigin = origin;
+    }
+
+    glm::vec2 SVGRasterizer::Jitter(int x, int y) const {
+        if (!_noise or _sample < 0 or _samples < 2) return glm::vec2(0.0f);
+        // the whole lattice moves together, so the samples keep their even spacing; the two axes read the
+        // tile at toroidal shifts far enough apart to be close to independent
+        constexpr int mask = NoiseTile - 1;
+        int px = x + _noiseOrigin.x, py = y + _noiseOrigin.y;
+        glm::vec2 u(
+            _noise[(py & mask) * NoiseTile + (px & mask)],
+            _noise[((py + NoiseTile / 3) & mask) * NoiseTile + ((px + NoiseTile / 2) & mask)]);
+        return (u - 0.5f) / float(_samples);
+    }
+
     void SVGRasterizer::DrawRect(Common::ImageRGB& image, Rect* rect) {
         int minX = std::max(0, (int)rect->x);
         int maxX = std::min((int)image.GetSizeX(), (int)(rect->x + rect->width));
@@ -81,24 +196,31 @@ namespace VCX::Labs::GettingStarted {
         int minY = std::max(0, (int)std::floor(circle->cy - outerR));
         int maxY = std::min((int)image.GetSizeY() - 1, (int)std::ceil(circle->cy + outerR));
 
-        for (int i = minX; i <= maxX; i++) {
-            for (int j = minY; j <= maxY; j++) {
-                float dx = (float)i - circle->cx;
-                float dy = (float)j - circle->cy;
-                float distSq = dx * dx + dy * dy;
-                float dist = std::sqrt(distSq);
+        for (int j = minY; j <= maxY; j++) {
+            // 0: outside, 1: stroke, 2: fill
+            int runStart = minX, runKind = 0;
+            for (int i = minX; i <= maxX + 1; i++) {
+                int kind = 0;
+                if (i <= maxX) {
+                    glm::vec2 jitter = Jitter(i, j);
+                    float dx = (float)i + jitter.x - circle->cx;
+                    float dy = (float)j + jitter.y - circle->cy;
+                    float distSq = dx * dx + dy * dy;
+                    float dist = std::sqrt(distSq);
 
-                if (circle->strokeColor.a > 0.001f && dist <= outerR && dist >= innerR) {
-                    SetPixel(image, i, j, circle->strokeColor);
-                }
-                else if (dist < innerR) {
-                    SetPixel(image, i, j, circle->fillColor);
+                    if (circle->strokeColor.a > 0.001f && dist <= outerR && dist >= innerR) kind = 1;
+                    else if (dist < innerR) kind = 2;
                 }
+                if (kind == runKind) continue;
+                if (runKind == 1) FillSpan(image, j, runStart, i, circle->strokeColor, circle->strokePaint);
+                else if (runKind == 2) FillSpan(image, j, runStart, i, circle->fillColor, circle->fillPaint);
+                runStart = i;
+                runKind = kind;
             }
         }
     }
 
-    void SVGRasterizer::DrawTriangle(Common::ImageRGB& image, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 color) {
+    void SVGRasterizer::DrawTriangle(Common::ImageRGB& image, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 color, const Paint& paint) {
         int minX = std::max(0, (int)std::floor(std::min({p1.x, p2.x, p3.x})));
         int maxX = std::min((int)image.GetSizeX() - 1, (int)std::ceil(std::max({p1.x, p2.x, p3.x})));
         int minY = std::max(0, (int)std::floor(std::min({p1.y, p2.y, p3.y})));
@@ -109,13 +231,20 @@ namespace VCX::Labs::GettingStarted {
         };
     
         for (int y = minY; y <= maxY; y++) {
-            for (int x = minX; x <= maxX; x++) {
-                glm::vec2 p(x + 0.5, y + 0.5);
-                float d1 = cross_product(p1, p2, p);
-                float d2 = cross_product(p2, p3, p);
-                float d3 = cross_product(p3, p1, p);
-                if ((d1 >= 0 && d2 >= 0 && d3 >= 0) || (d1 <= 0 && d2 <= 0 && d3 <= 0)) {
-                    SetPixel(image, x, y, color);
+            int runStart = -1;
+            for (int x = minX; x <= maxX + 1; x++) {
+                bool inside = false;
+                if (x <= maxX) {
+                    glm::vec2 p = glm::vec2(x + 0.5f, y + 0.5f) + Jitter(x, y);
+                    float d1 = cross_product(p1, p2, p);
+                    float d2 = cross_product(p2, p3, p);
+                    float d3 = cross_product(p3, p1, p);
+                    inside = (d1 >= 0 && d2 >= 0 && d3 >= 0) || (d1 <= 0 && d2 <= 0 && d3 <= 0);
+                }
+                if (inside and runStart < 0) runStart = x;
+                else if (!inside and runStart >= 0) {
+                    FillSpan(image, y, runStart, x, color, paint);
+                    runStart = -1;
                 }
             }
         }
@@ -138,18 +267,18 @@ namespace VCX::Labs::GettingStarted {
         glm::vec2 edge2 = p_curr + n2 * r * side;
     
         if (path->linejoin == StrokeLinejoin::Bevel) {
-            DrawTriangle(image, p_curr, edge1, edge2, path->strokeColor);
+            DrawTriangle(image, p_curr, edge1, edge2, path->strokeColor, path->strokePaint);
         } 
         else if (path->linejoin == StrokeLinejoin::Miter) {
             glm::vec2 miterDir = glm::normalize(n1 + n2);
             float cosAlpha = glm::dot(miterDir, n1);
             float miterLen = r / cosAlpha;
             if (std::abs(miterLen) > 4.0 * r) {
-                DrawTriangle(image, p_curr, edge1, edge2, path->strokeColor);
+                DrawTriangle(image, p_curr, edge1, edge2, path->strokeColor, path->strokePaint);
             } else {
                 glm::vec2 miterPoint = p_curr + miterDir * miterLen * side;
-                DrawTriangle(image, p_curr, edge1, miterPoint, path->strokeColor);
-                DrawTriangle(image, p_curr, edge2, miterPoint, path->strokeColor);
+                DrawTriangle(image, p_curr, edge1, miterPoint, path->strokeColor, path->strokePaint);
+                DrawTriangle(image, p_curr, edge2, miterPoint, path->strokeColor, path->strokePaint);
             }
         }
     }
@@ -167,8 +296,9 @@ namespace VCX::Labs::GettingStarted {
 
         for (int i = minX; i <= maxX; i++) {
             for (int j = minY; j <= maxY; j++) {
-                float dx = (float)i - ellipse->cx;
-                float dy = (float)j - ellipse->cy;
+                glm::vec2 jitter = Jitter(i, j);
+                float dx = (float)i + jitter.x - ellipse->cx;
+                float dy = (float)j + jitter.y - ellipse->cy;
                 float f = (dx * dx) / (rx * rx) + (dy * dy) / (ry * ry) - 1.0f;
 
                 float gradX = (2.0f * dx) / (rx * rx);
@@ -186,10 +316,11 @@ namespace VCX::Labs::GettingStarted {
         }
     }
 
-    void SVGRasterizer::DrawLine(Common::ImageRGB& image, const glm::vec2& p1, const glm::vec2& p2, float width, glm::vec4 color, StrokeLinecap linecap) {
+    void SVGRasterizer::DrawLine(Common::ImageRGB& image, const glm::vec2& p1, const glm::vec2& p2, float width, glm::vec4 color, const Paint& paint, StrokeLinecap linecap) {
         if (width < 1e-6 or color.a < 1e-6) return;
         float halfwidth = width * 0.5f;
-        halfwidth = std::max(0.5f, halfwidth);
+        // one sample per pixel widens hairlines so they do not break up; several samples cover them by share
+        if (_sample < 0) halfwidth = std::max(0.5f, halfwidth);
         int minX = std::max(0, (int)std::floor(std::min(p1.x, p2.x) - halfwidth));
         int maxX = std::min((int)image.GetSizeX() - 1, (int)std::ceil(std::max(p1.x, p2.x) + halfwidth));
         int minY = std::max(0, (int)std::floor(std::min(p1.y, p2.y) - halfwidth));
@@ -199,29 +330,31 @@ namespace VCX::Labs::GettingStarted {
         float line_length = glm::length(line);
         if (line_length < 1e-6) return;
 
-        for (int x = minX; x <= maxX; x++) {
-            for (int y = minY; y <= maxY; y++) {
-                glm::vec2 p(x + 0.5, y + 0.5);
-                float t = glm::dot(p - p1, line) / line_length / line_length;
-                glm::vec2 proj = p1 + t * line;
-                bool inside = false;
-                if (linecap == StrokeLinecap::Butt) {
-                    if (t < 0.0f or t > 1.0f) continue;
-                    inside = (glm::length(p - proj) <= halfwidth + 0.01);
-                } else if (linecap == StrokeLinecap::Square) {
-                    float offset = halfwidth / line_length;
-                    if (t < -offset or t > 1.0f + offset) continue;
-                    inside = (glm::length(p - proj) <= halfwidth + 0.01);
-                } else {
-                    if (t < 0.0f) {
-                        inside = (glm::length(p - p1) <= halfwidth + 0.01);
-                    } else if (t > 1.0f) {
-                        inside = (glm::length(p - p2) <= halfwidth + 0.01);
-                    } else inside = (glm::length(p - proj) <= halfwidth + 0.01);
-                }
+        auto covered = [&](int x, int y) {
+            glm::vec2 p = glm::vec2(x + 0.5f, y + 0.5f) + Jitter(x, y);
+            float t = glm::dot(p - p1, line) / line_length / line_length;
+            glm::vec2 proj = p1 + t * line;
+            if (linecap == StrokeLinecap::Butt) {
+                if (t < 0.0f or t > 1.0f) return false;
+                return glm::length(p - proj) <= halfwidth + 0.01;
+            } else if (linecap == StrokeLinecap::Square) {
+                float offset = halfwidth / line_length;
+                if (t < -offset or t > 1.0f + offset) return false;
+                return glm::length(p - proj) <= halfwidth + 0.01;
+            }
+            if (t < 0.0f) return glm::length(p - p1) <= halfwidth + 0.01;
+            if (t > 1.0f) return glm::length(p - p2) <= halfwidth + 0.01;
+            return glm::length(p - proj) <= halfwidth + 0.01;
+        };
 
-                if (inside) {
-                    SetPixel(image, x, y, color);
+        for (int y = minY; y <= maxY; y++) {
+            int runStart = -1;
+            for (int x = minX; x <= maxX + 1; x++) {
+                bool inside = x <= maxX and covered(x, y);
+                if (inside and runStart < 0) runStart = x;
+                else if (!inside and runStart >= 0) {
+                    FillSpan(image, y, runStart, x, color, paint);
+                    runStart = -1;
                 }
             }
         }
@@ -238,11 +371,117 @@ namespace VCX::Labs::GettingStarted {
         }
     };
 
+    // Walks one subpath through the dash pattern, calling piece(p0, p1) for every visible part of a
+    // segment and join(i) for every interior vertex that falls inside a dash. Nothing is buffered;
+    // the parts of segments outside `view` only advance the dash phase. The phase is kept in double,
+    // so long segments with short dashes still make progress.
+    template <typename Piece, typename Join>
+    static void DashSubpath(const std::vector<glm::vec2>& points, const std::vector<float>& dashes, float offset, const glm::vec4& view, Piece&& piece, Join&& join) {
+        double period = 0.0;
+        for (float dash : dashes) period += dash;
+        int n = (int)dashes.size(), index = 0;
+        double remaining = dashes[0];
+        // consumes d units of pattern, skipping whole periods at once
+        auto advance = [&](double d) {
+            if (d >= remaining) {
+                d -= remaining;
+                index = (index + 1) % n;
+                remaining = dashes[index];
+                d = std::fmod(d, period);
+            }
+            while (d >= remaining) {
+                d -= remaining;
+                index = (index + 1) % n;
+                remaining = dashes[index];
+            }
+            remaining -= d;
+        };
+        double phase = std::fmod(double(offset), period);
+        advance(phase < 0 ? phase + period : phase);
+
+        bool closed = points.size() > 2 and glm::length(points.front() - points.back()) <= 1e-6;
+        bool startOn = index % 2 == 0;
+        for (size_t i = 0; i + 1 < points.size(); i++) {
+            glm::vec2 a = points[i], b = points[i + 1];
+            double length = glm::length(b - a);
+            if (length < 1e-6) continue;
+            // the part of the segment inside the view, [t0, t1] in length units
+            glm::dvec2 dir = glm::dvec2(b - a) / length;
+            double t0 = 0.0, t1 = length;
+            for (int axis = 0; axis < 2; axis++) {
+                double lo = axis == 0 ? view.x : view.y, hi = axis == 0 ? view.z : view.w, p = a[axis], d = dir[axis];
+                if (std::abs(d) < 1e-12) {
+                    if (p < lo or p > hi) t0 = t1 + 1.0;
+                    continue;
+                }
+                double u = (lo - p) / d, v = (hi - p) / d;
+                t0 = std::max(t0, std::min(u, v));
+                t1 = std::min(t1, std::max(u, v));
+            }
+            if (t0 >= t1) {
+                advance(length);
+                continue;
+            }
+            advance(t0);
+            double t = t0;
+            auto at = [&](double s) { return glm::vec2(glm::dvec2(a) + dir * s); };
+            while (t < t1) {
+                double step = std::min(remaining, t1 - t);
+                // zero-length dashes still get their caps
+                if (index % 2 == 0) piece(at(t), at(t + std::max(step, 1e-3)));
+                t += step;
+                remaining -= step;
+                if (remaining <= 1e-6) {
+                    index = (index + 1) % n;
+                    remaining = dashes[index];
+                }
+            }
+            advance(length - t1);
+            if (index % 2 == 0 and i + 2 < points.size()) join(i + 1);
+        }
+        if (closed and startOn and index % 2 == 0) join(0);
+    }
+
     void SVGRasterizer::StrokePath(Common::ImageRGB& image, Path* path) {
-        for (auto subpath : path->sub_paths) {
+        auto joinAt = [&](glm::vec2 prev, glm::vec2 cur, glm::vec2 next) {
+            if (path->linejoin == StrokeLinejoin::Round) {
+                Circle joincircle;
+                // circles sample pixel corners, the lines around them pixel centers; a multi-sample pass is
+                // shifted for the lines, so the join moves back to match
+                float shift = _sample >= 0 ? 0.5f : 0.0f;
+                joincircle.cx = cur.x - shift;
+                joincircle.cy = cur.y - shift;
+                joincircle.fillColor = path->strokeColor;
+                joincircle.fillPaint = path->strokePaint;
+                joincircle.strokeColor = {0, 0, 0, 0};
+                joincircle.r = path->strokeWidth * 0.5f;
+                DrawCircle(image, &joincircle);
+            }
+            else {
+                HandleLineJoin(image, prev, cur, next, path);
+            }
+        };
+
+        for (const auto& subpath : path->sub_paths) {
             if (subpath.size() < 2) continue;
+            if (!path->dashes.empty()) {
+                // dashes whose stroke cannot reach the image are culled
+                float margin = path->strokeWidth * 2.0f + 1.0f;
+                glm::vec4 view = { -margin, -margin, image.GetSizeX() + margin, image.GetSizeY() + margin };
+                bool closed = glm::length(subpath[0] - subpath.back()) <= 1e-6;
+                DashSubpath(subpath, path->dashes, path->dashOffset, view,
+                    [&](glm::vec2 p0, glm::vec2 p1) {
+                        DrawLine(image, p0, p1, path->strokeWidth, path->strokeColor, path->strokePaint, path->linecap);
+                    },
+                    [&](size_t i) {
+                        if (i > 0) joinAt(subpath[i - 1], subpath[i], subpath[i + 1]);
+                        else if (closed) joinAt(subpath[subpath.size() - 2], subpath[0], subpath[1]);
+                    });
+                continue;
+            }
+
             for (int i = 0; i < subpath.size() - 1; i++) {
-                DrawLine(image, subpath[i], subpath[i + 1], path->strokeWidth, path->strokeColor, path->linecap);
+                DrawLine(image, subpath[i], subpath[i + 1], path->strokeWidth, path->strokeColor, path->strokePaint, path->linecap);
             }
 
             bool flag = glm::length(subpath[0] - *subpath.rbegin()) <= 1e-6;
@@ -259,26 +498,31 @@ namespace VCX::Labs::GettingStarted {
                     next = subpath[1];
                 } 
                 else continue;
-                if (path->linejoin == StrokeLinejoin::Round) {
-                    Circle joincircle;
-                    joincircle.cx = cur.x;
-                    joincircle.cy = cur.y;
-                    joincircle.fillColor = path->strokeColor;
-                    joincircle.strokeColor = {0, 0, 0, 0};
-                    joincircle.r = path->strokeWidth * 0.5f;
-                    DrawCircle(image, &joincircle);
-                }
-                else {
-                    HandleLineJoin(image, prev, cur, next, path);
-                }
+                joinAt(prev, cur, next);
             } 
         }
     }
 
-    void SVGRasterizer::DrawPath(Common::ImageRGB& image, Path* path) {
-        // std::cout << path->fillColor.r << " " << path->fillColor.g << " " << path->fillColor.b << " " << path->fillColor.a << std::endl;
-        int MAXY = image.GetSizeY();
-        std::vector<std::vector<Edge> > EdgeTable(MAXY);
+    // rows [y0, y1) of [0, MAXY) that a sample point at a row's top can find inside the path, widened by margin
+    static glm::ivec2 RowRange(const Path& path, int MAXY, float margin = 0.0f) {
+        float lo = 1e30f, hi = -1e30f;
+        for (auto& subpath : path.sub_paths)
+            for (auto& p : subpath) {
+                lo = std::min(lo, p.y);
+                hi = std::max(hi, p.y);
+            }
+        return { (int)std::ceil(std::clamp(lo - margin, 0.0f, float(MAXY))), (int)std::ceil(std::clamp(hi + margin, 0.0f, float(MAXY))) };
+    }
+
+    // scan converts the fill region of path, calling emit(y, left, right) for each covered run with the two
+    // edges bounding it, their x_now taken at row y
+    template <typename F>
+    static void ScanEdges(const Path* path, int MAXY, F&& emit) {
+        // only the rows the path spans get an edge list
+        glm::ivec2 span = RowRange(*path, MAXY);
+        int Y0 = span.x, Y1 = span.y;
+        if (Y0 >= Y1) return;
+        std::vector<std::vector<Edge> > EdgeTable(Y1 - Y0);
         auto Addedge = [&](const glm::vec2& p1, const glm::vec2& p2) {
             if (std::abs(p1.y - p2.y) < 1e-6) return;
             Edge e;
@@ -286,14 +530,14 @@ namespace VCX::Labs::GettingStarted {
             const glm::vec2& top = (p1.y < p2.y) ? p2 : p1;
             
             int y_start = static_cast<int>(std::ceil(bottom.y));
-            if (y_start < 0) y_start = 0;
-            if (y_start >= MAXY or y_start >= top.y) return;
+            if (y_start < Y0) y_start = Y0;
+            if (y_start >= Y1 or y_start >= top.y) return;
 
             e.y_max   = top.y;
             e.dx      = (p2.x - p1.x) / (p2.y - p1.y);
             e.x_now   = bottom.x + (static_cast<float>(y_start) - bottom.y) * e.dx;
             e.dir = (p1.y < p2.y) ? 1 : -1;
-            EdgeTable[y_start].push_back(e);
+            EdgeTable[y_start - Y0].push_back(e);
         };
 
         for (auto subpath : path->sub_paths) {
@@ -304,43 +548,886 @@ namespace VCX::Labs::GettingStarted {
                 Addedge(subpath.back(), subpath.front());
         }
 
-        for (int y = 0; y < MAXY; y++) {
-            if (EdgeTable[y].size() == 0) continue;
-            std::sort(EdgeTable[y].begin(), EdgeTable[y].end());
+        for (int y = Y0; y < Y1; y++) {
+            std::vector<Edge>& row = EdgeTable[y - Y0];
+            if (row.size() == 0) continue;
+            std::sort(row.begin(), row.end());
             int dircount = 0, numbercount = 0;
-            int prex = std::ceil(EdgeTable[y][0].x_now), nowx;
-            dircount += EdgeTable[y][0].dir;
+            Edge pre = row[0], now;
+            dircount += row[0].dir;
             numbercount++;
-            if (EdgeTable[y][0].y_max > y + 1 and y + 1 < MAXY) {
-                EdgeTable[y][0].x_now += EdgeTable[y][0].dx;
-                EdgeTable[y + 1].push_back(EdgeTable[y][0]);
+            if (row[0].y_max > y + 1 and y + 1 < Y1) {
+                row[0].x_now += row[0].dx;
+                EdgeTable[y + 1 - Y0].push_back(row[0]);
             }
-            for (int i = 1; i < EdgeTable[y].size(); i++) {
-                nowx = std::ceil(EdgeTable[y][i].x_now);
+            for (int i = 1; i < row.size(); i++) {
+                now = row[i];
                 if ((path->fill_rule == FillRule::EvenOdd and numbercount % 2 == 1) or (path->fill_rule == FillRule::NonZero and dircount != 0) ) {
-                    
-                    for (int x = prex; x < nowx; x++) {
-                        SetPixel(image, x, y, path->fillColor);
-                    }
+                    emit(y, pre, now);
                 }
-                dircount += EdgeTable[y][i].dir;
+                dircount += row[i].dir;
                 numbercount++;
-                if (EdgeTable[y][i].y_max > y + 1 and y + 1 < MAXY) {
-                    EdgeTable[y][i].x_now += EdgeTable[y][i].dx;
-                    EdgeTable[y + 1].push_back(EdgeTable[y][i]);
+                if (row[i].y_max > y + 1 and y + 1 < Y1) {
+                    row[i].x_now += row[i].dx;
+                    EdgeTable[y + 1 - Y0].push_back(row[i]);
                 }
-                prex = nowx;
+                pre = now;
             }
         }
+    }
+
+    // calls emit(y, x0, x1) for each run of pixels whose corner lies in the fill region
+    template <typename F>
+    static void ScanPath(const Path* path, int MAXY, F&& emit) {
+        ScanEdges(path, MAXY, [&](int y, const Edge& left, const Edge& right) {
+            emit(y, (int)std::ceil(left.x_now), (int)std::ceil(right.x_now));
+        });
+    }
+
+    // ScanPath with each pixel sampled at its corner plus jitter(x, y), which stays within a quarter pixel.
+    // The edges bounding a run are taken as straight across that quarter row, so only the pixels the jitter
+    // can move across one are tested; runs are clamped to [0, MAXX).
+    template <typename J, typename F>
+    static void ScanJittered(const Path* path, int MAXX, int MAXY, J&& jitter, F&& emit) {
+        ScanEdges(path, MAXY, [&](int y, const Edge& left, const Edge& right) {
+            float reachL = std::abs(left.dx) * 0.25f + 0.25f, reachR = std::abs(right.dx) * 0.25f + 0.25f;
+            int x0 = std::max(0, (int)std::ceil(std::max(left.x_now - reachL, -1.0f)));
+            int x1 = std::min(MAXX, (int)std::ceil(std::min(right.x_now + reachR, float(MAXX))));
+            int in0 = (int)std::ceil(std::clamp(left.x_now + reachL, -1.0f, float(MAXX)));
+            int in1 = (int)std::ceil(std::clamp(right.x_now - reachR, -1.0f, float(MAXX)));
+            int start = -1;
+            for (int x = x0; x <= x1; x++) {
+                bool inside = x < x1 and x >= in0 and x < in1;
+                if (x < x1 and !inside) {
+                    glm::vec2 j = jitter(x, y);
+                    inside = left.x_now + left.dx * j.y <= x + j.x and x + j.x < right.x_now + right.dx * j.y;
+                }
+                if (inside and start < 0) start = x;
+                else if (!inside and start >= 0) {
+                    emit(y, start, x);
+                    start = -1;
+                }
+            }
+        });
+    }
+
+    static Path Shifted(const Path& path, glm::vec2 offset) {
+        Path moved = path;
+        for (auto& subpath : moved.sub_paths)
+            for (auto& p : subpath) p += offset;
+        return moved;
+    }
+
+    void SVGRasterizer::DrawPath(Common::ImageRGB& image, Path* path) {
+        // std::cout << path->fillColor.r << " " << path->fillColor.g << " " << path->fillColor.b << " " << path->fillColor.a << std::endl;
+        if (path->fillColor.a >= 1e-6)
+            ScanPath(path, image.GetSizeY(), [&](int y, int x0, int x1) {
+                FillSpan(image, y, x0, x1, path->fillColor, path->fillPaint);
+            });
         if (path->strokeColor.a > 1e-6 and path->strokeWidth > 1e-6) {
             StrokePath(image, path);
         }
     }
     
+    Path SVGRasterizer::StyleInstance(Use* use, int entry) {
+        const auto& e = use->definition->entries[entry];
+        const glm::mat3& T = use->transform;
+        float linearScale = std::sqrt(std::abs(T[0][0] * T[1][1] - T[1][0] * T[0][1]));
+        float strokeScale = std::sqrt(std::abs(glm::determinant(e.transform)));
+        RenderStyle state = InheritStyle(use->style, e.style);
+
+        Path instance;
+        instance.fill_rule = e.path->fill_rule;
+        instance.fillColor = state.fill;
+        instance.fillColor.a *= state.totalOpacity;
+        instance.strokeColor = state.stroke;
+        instance.strokeColor.a *= state.totalOpacity;
+        instance.strokeWidth = state.strokeWidth * strokeScale * linearScale;
+        for (float dash : state.dashArray) instance.dashes.push_back(dash * strokeScale * linearScale);
+        instance.dashOffset = state.dashOffset * strokeScale * linearScale;
+        instance.linecap = state.linecap;
+        instance.linejoin = state.linejoin;
+        if (!use->fillPaints.empty()) instance.fillPaint = use->fillPaints[entry];
+        if (!use->strokePaints.empty()) instance.strokePaint = use->strokePaints[entry];
+        return instance;
+    }
+
+    SVGRasterizer::MaskKey SVGRasterizer::GetMaskKey(Use* use, int entry, const Path& instance) {
+        const glm::mat3& T = use->transform;
+        // subpixel offset quantized to 1/8 pixel
+        int fx = (int)std::floor((T[2][0] - std::floor(T[2][0])) * 8.0f);
+        int fy = (int)std::floor((T[2][1] - std::floor(T[2][1])) * 8.0f);
+        return { use->definition.get(), entry, T[0][0], T[0][1], T[1][0], T[1][1],
+                 instance.strokeWidth, (int)instance.linecap, (int)instance.linejoin, fx, fy, instance.dashes, instance.dashOffset };
+    }
+
+    const SVGRasterizer::CoverageMask& SVGRasterizer::GetMask(const MaskKey& key, Use* use, int entry, const Path& instance) {
+        auto it = _masks.find(key);
+        if (it != _masks.end()) return it->second;
+
+        const glm::mat3& T = use->transform;
+        glm::vec2 frac = { T[2][0] - std::floor(T[2][0]), T[2][1] - std::floor(T[2][1]) };
+        Path geometry;
+        geometry.fill_rule = instance.fill_rule;
+        geometry.linecap = instance.linecap;
+        geometry.linejoin = instance.linejoin;
+        geometry.dashes = instance.dashes;
+        geometry.dashOffset = instance.dashOffset;
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        for (auto& subpath : use->definition->entries[entry].path->sub_paths) {
+            geometry.sub_paths.push_back({});
+            geometry.sub_paths.back().reserve(subpath.size());
+            for (auto& p : subpath) {
+                glm::vec2 q = glm::vec2(T[0][0] * p.x + T[1][0] * p.y, T[0][1] * p.x + T[1][1] * p.y) + frac;
+                lo = glm::min(lo, q);
+                hi = glm::max(hi, q);
+                geometry.sub_paths.back().push_back(q);
+            }
+        }
+
+        CoverageMask& mask = _masks[key];
+        // miter joins reach up to 4 half-widths past the outline
+        int margin = (int)std::ceil(instance.strokeWidth * 2.0f) + 2;
+        if (lo.x > hi.x) {
+            mask = { 0, 0, 0, 0, {}, {} };
+            return mask;
+        }
+        mask.x = (int)std::floor(lo.x) - margin;
+        mask.y = (int)std::floor(lo.y) - margin;
+        mask.width = (int)std::ceil(hi.x) + margin - mask.x;
+        mask.height = (int)std::ceil(hi.y) + margin - mask.y;
+        for (auto& subpath : geometry.sub_paths)
+            for (auto& p : subpath) p -= glm::vec2(mask.x, mask.y);
+
+        // coverage is recorded unclipped; the clip applies when the mask is blitted
+        const ClipMask* clip = _clip;
+        int surface = _surface;
+        _clip = nullptr;
+        _surface = -1;
+        auto render = [&](bool stroke) {
+            Common::ImageRGB scratch = Common::CreatePureImageRGB(mask.width, mask.height, glm::vec3{0.0f});
+            geometry.fillColor = stroke ? glm::vec4(0.0f) : glm::vec4(1.0f);
+            geometry.strokeColor = stroke ? glm::vec4(1.0f) : glm::vec4(0.0f);
+            geometry.fillPaint = geometry.strokePaint = Paint();
+            geometry.strokeWidth = stroke ? instance.strokeWidth : 0.0f;
+            if (stroke) StrokePath(scratch, &geometry);
+            else DrawPath(scratch, &geometry);
+            std::vector<unsigned char> coverage(mask.width * mask.height);
+            for (int j = 0; j < mask.height; j++) {
+                auto row = scratch.Row(j);
+                for (int i = 0; i < mask.width; i++) coverage[j * mask.width + i] = row[i].r;
+            }
+            return coverage;
+        };
+        mask.fill = render(false);
+        if (instance.strokeWidth > 1e-6) mask.stroke = render(true);
+        _clip = clip;
+        _surface = surface;
+        return mask;
+    }
+
+    void SVGRasterizer::BlitMask(Common::ImageRGB& image, const CoverageMask& mask, const std::vector<unsigned char>& coverage, int x, int y, glm::vec4 color, const Paint& paint) {
+        if (coverage.empty()) return;
+        int minX = std::max(0, -x), maxX = std::min(mask.width, (int)image.GetSizeX() - x);
+        int minY = std::max(0, -y), maxY = std::min(mask.height, (int)image.GetSizeY() - y);
+        // masks come from the binary scan converter, so covered pixels form runs
+        for (int j = minY; j < maxY; j++) {
+            const unsigned char* row = coverage.data() + j * mask.width;
+            int i = minX;
+            while (i < maxX) {
+                while (i < maxX and row[i] < 128) i++;
+                int start = i;
+                while (i < maxX and row[i] >= 128) i++;
+                if (i > start) FillSpan(image, y + j, x + start, x + i, color, paint);
+            }
+        }
+    }
+
+    static constexpr float       MaxGlyphEm = 256.0f;      // pixels per em; larger glyphs are scanned directly
+    static constexpr std::size_t GlyphBudget = 8 << 20;   // bytes of glyph coverage a rasterizer keeps
+
+    bool SVGRasterizer::DrawGlyph(Common::ImageRGB& image, Use* use, const Path& instance) {
+        const Definition& definition = *use->definition;
+        const glm::mat3& T = use->transform;
+        float ppem = T[0][0] * SVGFont::EmUnits;
+        if (!definition.font or ppem <= 0.0f or ppem > MaxGlyphEm) return false;
+        if (std::abs(T[0][1]) + std::abs(T[1][0]) + std::abs(T[1][1] - T[0][0]) > 1e-6f * T[0][0]) return false;
+        if (std::abs(T[2][0]) > 1e6f or std::abs(T[2][1]) > 1e6f) return false;
+
+        // the pen snaps to a quarter pixel across and a whole pixel down
+        int qx = (int)std::floor(T[2][0] * 4.0f + 0.5f);
+        int px = (int)std::floor(qx / 4.0f), py = (int)std::floor(T[2][1] + 0.5f);
+        const GlyphMask& mask = GetGlyph({ definition.font, definition.glyph, (int)std::lround(ppem * 16.0f), qx - px * 4 });
+
+        int x0 = px + mask.x, y0 = py + mask.y;
+        for (int j = 0; j < mask.height; j++) {
+            const unsigned char* row = mask.coverage.data() + j * mask.width;
+            int i = 0;
+            while (i < mask.width) {
+                if (row[i] == 0) i++;
+                else if (row[i] == 255) {
+                    int start = i;
+                    while (i < mask.width and row[i] == 255) i++;
+                    FillSpan(image, y0 + j, x0 + start, x0 + i, instance.fillColor, instance.fillPaint);
+                }
+                else {
+                    glm::vec4 color = instance.fillColor;
+                    color.a *= row[i] / 255.0f;
+                    FillSpan(image, y0 + j, x0 + i, x0 + i + 1, color, instance.fillPaint);
+                    i++;
+                }
+            }
+        }
+        return true;
+    }
+
+    const SVGRasterizer::GlyphMask& SVGRasterizer::GetGlyph(const GlyphKey& key) {
+        auto it = _glyphs.find(key);
+        if (it != _glyphs.end()) return it->second;
+        // a full cache starts over; the glyphs one document keeps using come back within a frame
+        if (_glyphBytes > GlyphBudget) {
+            _glyphs.clear();
+            _glyphBytes = 0;
+        }
+
+        auto [font, glyph, size, offset] = key;
+        float scale = size / 16.0f / SVGFont::EmUnits;
+        // flattened to a tenth of a pixel at this size
+        Path outline = font->Flatten(glyph, 0.1f / scale);
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        for (auto& subpath : outline.sub_paths)
+            for (auto& p : subpath) {
+                p = p * scale + glm::vec2(offset * 0.25f, 0.0f);
+                lo = glm::min(lo, p);
+                hi = glm::max(hi, p);
+            }
+
+        GlyphMask& mask = _glyphs[key];
+        if (lo.x > hi.x) {
+            mask = { 0, 0, 0, 0, {} };
+            return mask;
+        }
+        mask.x = (int)std::floor(lo.x);
+        mask.y = (int)std::floor(lo.y);
+        mask.width = std::max(1, (int)std::ceil(hi.x) - mask.x);
+        mask.height = std::max(1, (int)std::ceil(hi.y) - mask.y);
+
+        // 4 x 4 samples at the centers of each pixel's quarter cells, counted per pixel
+        for (auto& subpath : outline.sub_paths)
+            for (auto& p : subpath) p = (p - glm::vec2(mask.x, mask.y)) * 4.0f - 0.5f;
+        std::vector<int> counts(mask.width * mask.height);
+        ScanPath(&outline, mask.height * 4, [&](int y, int x0, int x1) {
+            x0 = std::max(x0, 0);
+            x1 = std::min(x1, mask.width * 4);
+            int* row = counts.data() + (y / 4) * mask.width;
+            while (x0 < x1) {
+                int end = std::min(x1, (x0 / 4 + 1) * 4);
+                row[x0 / 4] += end - x0;
+                x0 = end;
+            }
+        });
+        mask.coverage.resize(counts.size());
+        for (std::size_t i = 0; i < counts.size(); i++) mask.coverage[i] = (unsigned char)((counts[i] * 255 + 8) / 16);
+        _glyphBytes += mask.coverage.size() + sizeof(GlyphMask);
+        return mask;
+    }
+
+    void SVGRasterizer::DrawUse(Common::ImageRGB& image, Use* use) {
+        const glm::mat3& T = use->transform;
+        auto& entries = use->definition->entries;
+        for (int i = 0; i < entries.size(); i++) {
+            Path instance = StyleInstance(use, i);
+            bool hasFill = instance.fillColor.a >= 0.001f;
+            bool hasStroke = instance.strokeColor.a > 1e-6 and instance.strokeWidth > 1e-6;
+            if (!hasFill and !hasStroke) continue;
+
+            if (!hasStroke and DrawGlyph(image, use, instance)) continue;
+            MaskKey key = GetMaskKey(use, i, instance);
+            if (_maskUses[key] >= 2) {
+                const CoverageMask& mask = GetMask(key, use, i, instance);
+                int x = (int)std::floor(T[2][0]) + mask.x;
+                int y = (int)std::floor(T[2][1]) + mask.y;
+                if (hasFill) BlitMask(image, mask, mask.fill, x, y, instance.fillColor, instance.fillPaint);
+                if (hasStroke) BlitMask(image, mask, mask.stroke, x, y, instance.strokeColor, instance.strokePaint);
+                continue;
+            }
+
+            for (auto& subpath : entries[i].path->sub_paths) {
+                instance.sub_paths.push_back({});
+                instance.sub_paths.back().reserve(subpath.size());
+                for (auto& p : subpath)
+                    instance.sub_paths.back().push_back(glm::vec2(T * glm::vec3(p, 1.0f)));
+            }
+            DrawPath(image, &instance);
+        }
+    }
+
+    // Each part of the shape is drawn once per sample, shifted so the scan converter's own sample point
+    // lands on that sample, with spans setting the sample's coverage bit; the part is then shaded once.
+    void SVGRasterizer::DrawSampled(Common::ImageRGB& image, Shape* shape) {
+        int width = image.GetSizeX(), height = image.GetSizeY();
+        const ClipPath* clip = shape->clip.get();
+        // `anchor` is where the primitives sample a pixel: fills at its corner, lines and triangles at its center
+        auto pass = [&](glm::vec2 anchor, const glm::vec4& color, const Paint& paint, auto&& draw) {
+            if (color.a < 1e-6) return;
+            for (int i = 0; i < _samples; i++) {
+                _sample = i;
+                _clip = clip ? &GetClipMask(clip, width, height, i) : nullptr;
+                draw(anchor - _sampleOffsets[i]);
+            }
+            _sample = -1;
+            _clip = nullptr;
+            ResolveCoverage(image, color, paint);
+        };
+        auto drawPath = [&](const Path& path) {
+            pass({ 0.0f, 0.0f }, path.fillColor, path.fillPaint, [&](glm::vec2 offset) {
+                Path moved = Shifted(path, offset);
+                auto fill = [&](int y, int x0, int x1) {
+                    FillSpan(image, y, x0, x1, path.fillColor, path.fillPaint);
+                };
+                if (_noise) ScanJittered(&moved, width, height, [&](int x, int y) { return Jitter(x, y); }, fill);
+                else ScanPath(&moved, height, fill);
+            });
+            if (path.strokeWidth > 1e-6)
+                pass({ 0.5f, 0.5f }, path.strokeColor, path.strokePaint, [&](glm::vec2 offset) {
+                    Path moved = Shifted(path, offset);
+                    StrokePath(image, &moved);
+                });
+        };
+
+        if (shape->type == ShapeType::Path) drawPath(*static_cast<Path*>(shape));
+        else if (shape->type == ShapeType::Use) {
+            Use* use = static_cast<Use*>(shape);
+            for (int i = 0; i < use->definition->entries.size(); i++) {
+                Path instance = StyleInstance(use, i);
+                for (auto& subpath : use->definition->entries[i].path->sub_paths) {
+                    instance.sub_paths.push_back({});
+                    instance.sub_paths.back().reserve(subpath.size());
+                    for (auto& p : subpath)
+                        instance.sub_paths.back().push_back(glm::vec2(use->transform * glm::vec3(p, 1.0f)));
+                }
+                drawPath(instance);
+            }
+        } else {
+            // these draw fill and stroke in one call, both sampled at the pixel corner
+            for (bool stroke : { false, true })
+                pass({ 0.0f, 0.0f }, stroke ? shape->strokeColor : shape->fillColor, stroke ? shape->strokePaint : shape->fillPaint, [&](glm::vec2 offset) {
+                    if (shape->type == ShapeType::Rectangle) {
+                        Rect rect = *static_cast<Rect*>(shape);
+                        rect.x += offset.x, rect.y += offset.y;
+                        (stroke ? rect.fillColor : rect.strokeColor).a = 0;
+                        DrawRect(image, &rect);
+                    } else if (shape->type == ShapeType::Circle) {
+                        Circle circle = *static_cast<Circle*>(shape);
+                        circle.cx += offset.x, circle.cy += offset.y;
+                        (stroke ? circle.fillColor : circle.strokeColor).a = 0;
+                        DrawCircle(image, &circle);
+                    } else if (shape->type == ShapeType::Ellipse) {
+                        Ellipse ellipse = *static_cast<Ellipse*>(shape);
+                        ellipse.cx += offset.x, ellipse.cy += offset.y;
+                        (stroke ? ellipse.fillColor : ellipse.strokeColor).a = 0;
+                        DrawEllipse(image, &ellipse);
+                    }
+                });
+        }
+    }
+
+    void SVGRasterizer::Cover(int y, int x0, int x1) {
+        if (y < 0 or std::size_t(y) * _coverageWidth >= _coverage.size()) return;
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, _coverageWidth);
+        if (x0 >= x1) return;
+        uint32_t bit = uint32_t(1) << _sample;
+        uint32_t* row = _coverage.data() + std::size_t(y) * _coverageWidth;
+        for (int x = x0; x < x1; x++) row[x] |= bit;
+        _covered = { std::min(_covered.x, x0), std::min(_covered.y, y), std::max(_covered.z, x1), std::max(_covered.w, y + 1) };
+    }
+
+    // shades runs of pixels with equal coverage at the color's alpha scaled by that coverage, clearing the bits
+    void SVGRasterizer::ResolveCoverage(Common::ImageRGB& image, const glm::vec4& color, const Paint& paint) {
+        for (int y = _covered.y; y < _covered.w; y++) {
+            uint32_t* row = _coverage.data() + std::size_t(y) * _coverageWidth;
+            for (int x = _covered.x; x < _covered.z;) {
+                int count = std::popcount(row[x]), start = x;
+                while (x < _covered.z and std::popcount(row[x]) == count) row[x++] = 0;
+                if (count > 0) ShadeSpan(image, y, start, x, glm::vec4(glm::vec3(color), color.a * count / _samples), paint);
+            }
+        }
+        _covered = { _coverageWidth, int(_coverage.size() / std::max(_coverageWidth, 1)), 0, 0 };
+    }
+
+    glm::vec4 SVGRasterizer::GetBounds(Shape* shape) {
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        float margin = 0.0f;
+        auto addPath = [&](const Path& path, const glm::mat3& T) {
+            for (auto& subpath : path.sub_paths)
+                for (auto& p : subpath) {
+                    glm::vec2 q = glm::vec2(T * glm::vec3(p, 1.0f));
+                    lo = glm::min(lo, q);
+                    hi = glm::max(hi, q);
+                }
+        };
+        if (shape->type == ShapeType::Rectangle) {
+            auto rect = static_cast<Rect*>(shape);
+            lo = { rect->x, rect->y };
+            hi = { rect->x + rect->width, rect->y + rect->height };
+            margin = rect->strokeWidth;
+        } else if (shape->type == ShapeType::Circle) {
+            auto circle = static_cast<Circle*>(shape);
+            lo = glm::vec2(circle->cx, circle->cy) - circle->r;
+            hi = glm::vec2(circle->cx, circle->cy) + circle->r;
+            margin = circle->strokeWidth;
+        } else if (shape->type == ShapeType::Ellipse) {
+            auto ellipse = static_cast<Ellipse*>(shape);
+            lo = { ellipse->cx - ellipse->rx, ellipse->cy - ellipse->ry };
+            hi = { ellipse->cx + ellipse->rx, ellipse->cy + ellipse->ry };
+            margin = ellipse->strokeWidth;
+        } else if (shape->type == ShapeType::Path) {
+            addPath(*static_cast<Path*>(shape), glm::mat3(1.0f));
+            margin = shape->strokeWidth * 2.0f;
+        } else if (shape->type == ShapeType::Use) {
+            Use* use = static_cast<Use*>(shape);
+            for (int i = 0; i < use->definition->entries.size(); i++) {
+                addPath(*use->definition->entries[i].path, use->transform);
+                margin = std::max(margin, StyleInstance(use, i).strokeWidth * 2.0f);
+            }
+        }
+        // miter joins reach up to 4 half-widths past the outline
+        return { lo.x - margin - 2.0f, lo.y - margin - 2.0f, hi.x + margin + 2.0f, hi.y + margin + 2.0f };
+    }
+
+    // Children are drawn straight onto the canvas; at LayerEnd the touched region is blended back
+    // toward the saved backdrop. With source-over that equals compositing an isolated layer:
+    // lerp(B, children over B, o) = B (1 - o a) + o (children premultiplied).
+    // Filtered layers need the children's own alpha, so they get a transparent surface instead.
+    void SVGRasterizer::BeginLayer(Common::ImageRGB& image, const std::vector<Shape*>& shapes, int index) {
+        Layer* begin = static_cast<Layer*>(shapes[index]);
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        for (int i = index + 1, depth = 1; i < shapes.size(); i++) {
+            if (shapes[i]->type == ShapeType::LayerBegin) depth++;
+            else if (shapes[i]->type == ShapeType::LayerEnd and --depth == 0) break;
+            else if (shapes[i]->type != ShapeType::LayerEnd) {
+                glm::vec4 b = GetBounds(shapes[i]);
+                lo = glm::min(lo, glm::vec2(b.x, b.y));
+                hi = glm::max(hi, glm::vec2(b.z, b.w));
+            }
+        }
+        if (begin->filter) {
+            // blur and offset spread the content; a flood fills the whole filter region
+            glm::vec2 reach(0.0f);
+            bool flood = false;
+            for (auto& primitive : begin->filter->primitives) {
+                reach += 3.0f * primitive.stdDeviation + glm::abs(primitive.offset);
+                flood = flood or primitive.kind == FilterKind::Flood;
+            }
+            const glm::vec4& region = begin->filter->region;
+            lo = flood ? glm::vec2(region.x, region.y) : glm::max(lo - reach, glm::vec2(region.x, region.y));
+            hi = flood ? glm::vec2(region.z, region.w) : glm::min(hi + reach, glm::vec2(region.z, region.w));
+        }
+
+        int targetX = 0, targetY = 0, targetWidth = image.GetSizeX(), targetHeight = image.GetSizeY();
+        if (_surface >= 0) {
+            const LayerState& target = _layers[_surface];
+            targetX = target.x, targetY = target.y, targetWidth = target.width, targetHeight = target.height;
+        }
+        LayerState layer;
+        layer.x = std::max(targetX, (int)std::floor(lo.x));
+        layer.y = std::max(targetY, (int)std::floor(lo.y));
+        layer.width = std::max(0, std::min(targetX + targetWidth, (int)std::ceil(hi.x) + 1) - layer.x);
+        layer.height = std::max(0, std::min(targetY + targetHeight, (int)std::ceil(hi.y) + 1) - layer.y);
+        layer.opacity = begin->opacity;
+        layer.filter = begin->filter;
+        if (!_layerPool.empty()) {
+            layer.pixels.swap(_layerPool.back());
+            _layerPool.pop_back();
+        }
+        if (layer.filter) layer.pixels.assign(layer.width * layer.height, glm::vec4(0.0f));
+        else {
+            layer.pixels.resize(layer.width * layer.height);
+            for (int j = 0; j < layer.height; j++)
+                for (int i = 0; i < layer.width; i++)
+                    layer.pixels[j * layer.width + i] = ReadPixel(image, layer.x + i, layer.y + j);
+        }
+        _layers.push_back(std::move(layer));
+        if (_layers.back().filter) _surface = (int)_layers.size() - 1;
+    }
+
+    // running-sum box blur of `count` samples `stride` apart, averaging [i - left, i + right]; outside is transparent
+    static void BoxBlurLine(const glm::vec4* src, glm::vec4* dst, int count, int stride, int left, int right) {
+        float inv = 1.0f / (left + right + 1);
+        glm::vec4 sum(0.0f);
+        for (int i = 0; i <= std::min(right, count - 1); i++) sum += src[i * stride];
+        for (int i = 0; i < count; i++) {
+            dst[i * stride] = sum * inv;
+            if (i + right + 1 < count) sum += src[(i + right + 1) * stride];
+            if (i - left >= 0) sum -= src[(i - left) * stride];
+        }
+    }
+
+    // three box blurs approximate a gaussian (SVG 1.1 feGaussianBlur):
+    // d = floor(s * 3 sqrt(2 pi) / 4 + 0.5), odd d: three centered boxes, even d: two offset boxes of d and a centered d + 1
+    static std::vector<std::pair<int, int>> BoxWindows(float s) {
+        int d = (int)std::floor(s * 3.0f * std::sqrt(2.0f * glm::pi<float>()) / 4.0f + 0.5f);
+        if (d <= 1) return {};
+        if (d % 2 == 1) return { { d / 2, d / 2 }, { d / 2, d / 2 }, { d / 2, d / 2 } };
+        return { { d / 2, d / 2 - 1 }, { d / 2 - 1, d / 2 }, { d / 2, d / 2 } };
+    }
+
+    static void GaussianBlur(std::vector<glm::vec4>& pixels, int width, int height, glm::vec2 stdDeviation) {
+        constexpr int TileRows = 32, TileColumns = 64;
+        auto windowsX = BoxWindows(stdDeviation.x);
+        auto windowsY = BoxWindows(stdDeviation.y);
+
+        // rows are independent: bands of rows run on the pool
+        if (!windowsX.empty())
+            Engine::ParallelFor(0, (height + TileRows - 1) / TileRows, [&](int tile) {
+                std::vector<glm::vec4> a(width), b(width);
+                for (int y = tile * TileRows; y < std::min(height, (tile + 1) * TileRows); y++) {
+                    glm::vec4* row = pixels.data() + y * width;
+                    BoxBlurLine(row, a.data(), width, 1, windowsX[0].first, windowsX[0].second);
+                    BoxBlurLine(a.data(), b.data(), width, 1, windowsX[1].first, windowsX[1].second);
+                    BoxBlurLine(b.data(), row, width, 1, windowsX[2].first, windowsX[2].second);
+                }
+            });
+
+        // columns run a whole strip at once: the running sums are a row of accumulators,
+        // so the inner loops walk contiguous memory and vectorize
+        if (!windowsY.empty()) {
+            std::vector<glm::vec4> scratch(pixels.size());
+            Engine::ParallelFor(0, (width + TileColumns - 1) / TileColumns, [&](int tile) {
+                int x0 = tile * TileColumns, x1 = std::min(width, x0 + TileColumns), n = x1 - x0;
+                std::vector<glm::vec4> sum(n);
+                glm::vec4* buffers[2] = { pixels.data(), scratch.data() };
+                for (int pass = 0; pass < 3; pass++) {
+                    const glm::vec4* src = buffers[pass % 2] + x0;
+                    glm::vec4* dst = buffers[(pass + 1) % 2] + x0;
+                    auto [left, right] = windowsY[pass];
+                    float inv = 1.0f / (left + right + 1);
+                    std::fill(sum.begin(), sum.end(), glm::vec4(0.0f));
+                    for (int y = 0; y <= std::min(right, height - 1); y++)
+                        for (int x = 0; x < n; x++) sum[x] += src[y * width + x];
+                    for (int y = 0; y < height; y++) {
+                        glm::vec4* out = dst + y * width;
+                        for (int x = 0; x < n; x++) out[x] = sum[x] * inv;
+                        if (y + right + 1 < height) {
+                            const glm::vec4* in = src + (y + right + 1) * width;
+                            for (int x = 0; x < n; x++) sum[x] += in[x];
+                        }
+                        if (y - left >= 0) {
+                            const glm::vec4* in = src + (y - left) * width;
+                            for (int x = 0; x < n; x++) sum[x] -= in[x];
+                        }
+                    }
+                }
+                // three passes leave the result in scratch
+                for (int y = 0; y < height; y++)
+                    std::copy(scratch.begin() + y * width + x0, scratch.begin() + y * width + x1, pixels.begin() + y * width + x0);
+            });
+        }
+    }
+
+    // runs the primitive chain over a premultiplied layer surface
+    static std::vector<glm::vec4> RunFilter(const Filter& filter, const std::vector<glm::vec4>& source, int width, int height) {
+        std::map<std::string, std::vector<glm::vec4>> results;
+        std::vector<glm::vec4> previous = source;
+        auto input = [&](const std::string& name) {
+            if (name == "SourceGraphic") return source;
+            if (name == "SourceAlpha") {
+                std::vector<glm::vec4> alpha(source.size());
+                for (size_t i = 0; i < source.size(); i++) alpha[i] = { 0, 0, 0, source[i].a };
+                return alpha;
+            }
+            auto it = results.find(name);
+            return it != results.end() ? it->second : previous;
+        };
+
+        for (auto& primitive : filter.primitives) {
+            std::vector<glm::vec4> result;
+            if (primitive.kind == FilterKind::GaussianBlur) {
+                result = input(primitive.in[0]);
+                GaussianBlur(result, width, height, primitive.stdDeviation);
+            } else if (primitive.kind == FilterKind::Offset) {
+                std::vector<glm::vec4> in = input(primitive.in[0]);
+                int dx = (int)std::round(primitive.offset.x), dy = (int)std::round(primitive.offset.y);
+                result.assign(in.size(), glm::vec4(0.0f));
+                for (int y = std::max(0, dy); y < std::min(height, height + dy); y++)
+                    for (int x = std::max(0, dx); x < std::min(width, width + dx); x++)
+                        result[y * width + x] = in[(y - dy) * width + x - dx];
+            } else if (primitive.kind == FilterKind::Flood) {
+                glm::vec4 flood = primitive.flood;
+                result.assign(source.size(), glm::vec4(glm::vec3(flood) * flood.a, flood.a));
+            } else if (primitive.kind == FilterKind::Merge) {
+                result.assign(source.size(), glm::vec4(0.0f));
+                for (auto& name : primitive.in) {
+                    std::vector<glm::vec4> in = input(name);
+                    for (size_t i = 0; i < result.size(); i++) result[i] = in[i] + result[i] * (1.0f - in[i].a);
+                }
+            }
+            if (!primitive.result.empty()) results[primitive.result] = result;
+            previous = std::move(result);
+        }
+        return previous;
+    }
+
+    void SVGRasterizer::EndLayer(Common::ImageRGB& image) {
+        if (_layers.empty()) return;
+        LayerState layer = std::move(_layers.back());
+        _layers.pop_back();
+        if (layer.filter) {
+            _surface = -1;
+            for (int i = (int)_layers.size() - 1; i >= 0 and _surface < 0; i--)
+                if (_layers[i].filter) _surface = i;
+            std::vector<glm::vec4> result = RunFilter(*layer.filter, layer.pixels, layer.width, layer.height);
+            for (int j = 0; j < layer.height; j++)
+                for (int i = 0; i < layer.width; i++) {
+                    glm::vec4 src = result[j * layer.width + i] * layer.opacity;
+                    if (src.a <= 0.0f) continue;
+                    glm::vec4 dst = ReadPixel(image, layer.x + i, layer.y + j);
+                    WritePixel(image, layer.x + i, layer.y + j, src + dst * (1.0f - src.a));
+                }
+        } else {
+            for (int j = 0; j < layer.height; j++)
+                for (int i = 0; i < layer.width; i++) {
+                    glm::vec4 src = ReadPixel(image, layer.x + i, layer.y + j);
+                    const glm::vec4& dst = layer.pixels[j * layer.width + i];
+                    WritePixel(image, layer.x + i, layer.y + j, dst + (src - dst) * layer.opacity);
+                }
+        }
+        _layerPool.push_back(std::move(layer.pixels));
+    }
+
+    static glm::vec4 SampleLut(const Gradient& gradient, float t) {
+        if (gradient.spread == SpreadMethod::Repeat) t -= std::floor(t);
+        else if (gradient.spread == SpreadMethod::Reflect) {
+            t = std::abs(t) - 2.0f * std::floor(std::abs(t) * 0.5f);
+            if (t > 1.0f) t = 2.0f - t;
+        }
+        t = std::clamp(t, 0.0f, 1.0f);
+        return gradient.lut[(int)(t * (Gradient::LutSize - 1) + 0.5f)];
+    }
+
+    const SVGRasterizer::ClipMask& SVGRasterizer::GetClipMask(const ClipPath* clip, int width, int height, int sample) {
+        auto it = _clipMasks.find({ clip, sample });
+        if (it != _clipMasks.end()) return it->second;
+
+        // the rows the clip children can reach, a pixel wider for the sample shifts; a nested clip
+        // never reaches past its parent
+        const ClipMask* parent = clip->parent ? &GetClipMask(clip->parent.get(), width, height, sample) : nullptr;
+        int y0 = height, y1 = 0;
+        for (auto path : clip->paths) {
+            glm::ivec2 span = RowRange(*path, height, 1.0f);
+            y0 = std::min(y0, span.x);
+            y1 = std::max(y1, span.y);
+        }
+        if (parent) {
+            y0 = std::max(y0, parent->y0);
+            y1 = std::min(y1, parent->y1);
+        }
+        y1 = std::max(y0, y1);
+
+        // union of the clip children, one sorted run list per row of [y0, y1)
+        std::vector<std::vector<std::pair<int, int>>> runs(y1 - y0);
+        auto add = [&](int y, int x0, int x1) {
+            x0 = std::max(x0, 0);
+            x1 = std::min(x1, width);
+            if (y >= y0 and y < y1 and x0 < x1) runs[y - y0].push_back({ x0, x1 });
+        };
+        for (auto path : clip->paths) {
+            if (sample < 0) ScanPath(path, height, add);
+            else {
+                Path moved = Shifted(*path, -_sampleOffsets[sample]);
+                if (_noise) ScanJittered(&moved, width, height, [&](int x, int y) { return Jitter(x, y); }, add);
+                else ScanPath(&moved, height, add);
+            }
+        }
+        for (auto& row : runs) {
+            std::sort(row.begin(), row.end());
+            int n = 0;
+            for (auto& r : row) {
+                if (n > 0 and r.first <= row[n - 1].second) row[n - 1].second = std::max(row[n - 1].second, r.second);
+                else row[n++] = r;
+            }
+            row.resize(n);
+        }
+
+        // nested clips intersect with the enclosing region
+        if (parent) {
+            for (int y = y0; y < y1; y++) {
+                std::vector<std::pair<int, int>> row;
+                auto a = runs[y - y0].begin();
+                auto b = parent->spans.begin() + parent->rows[y - parent->y0];
+                auto bEnd = parent->spans.begin() + parent->rows[y - parent->y0 + 1];
+                while (a != runs[y - y0].end() and b != bEnd) {
+                    int x0 = std::max(a->first, b->first), x1 = std::min(a->second, b->second);
+                    if (x0 < x1) row.push_back({ x0, x1 });
+                    if (a->second < b->second) a++;
+                    else b++;
+                }
+                runs[y - y0].swap(row);
+            }
+        }
+
+        ClipMask& mask = _clipMasks[{ clip, sample }];
+        int first = y0, last = y1;
+        while (first < last and runs[first - y0].empty()) first++;
+        while (last > first and runs[last - 1 - y0].empty()) last--;
+        mask.y0 = first;
+        mask.y1 = last;
+        mask.rows.push_back(0);
+        for (int y = first; y < last; y++) {
+            mask.spans.insert(mask.spans.end(), runs[y - y0].begin(), runs[y - y0].end());
+            mask.rows.push_back((int)mask.spans.size());
+        }
+        return mask;
+    }
+
+    void SVGRasterizer::FillSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint) {
+        // while a sample is drawn, spans only mark its coverage
+        if (_sample >= 0) {
+            if (color.a < 1e-6) return;
+            if (!_clip) {
+                Cover(y, x0, x1);
+                return;
+            }
+        }
+        if (!_clip) {
+            ShadeSpan(image, y, x0, x1, color, paint);
+            return;
+        }
+        if (y < _clip->y0 or y >= _clip->y1) return;
+        for (int k = _clip->rows[y - _clip->y0]; k < _clip->rows[y - _clip->y0 + 1]; k++) {
+            auto [cx0, cx1] = _clip->spans[k];
+            if (cx1 <= x0) continue;
+            if (cx0 >= x1) break;
+            if (_sample >= 0) Cover(y, std::max(x0, cx0), std::min(x1, cx1));
+            else ShadeSpan(image, y, std::max(x0, cx0), std::min(x1, cx1), color, paint);
+        }
+    }
+
+    // bilinear, clamped to the edge texels; transparent outside the bitmap
+    static glm::vec4 SampleBilinear(const Bitmap::Level& level, glm::vec2 p, glm::vec2 size) {
+        if (p.x < 0 or p.y < 0 or p.x >= size.x or p.y >= size.y) return glm::vec4(0.0f);
+        float u = p.x - 0.5f, v = p.y - 0.5f;
+        int i = (int)std::floor(u), j = (int)std::floor(v);
+        float fu = u - i, fv = v - j;
+        int i0 = std::clamp(i, 0, level.width - 1), i1 = std::clamp(i + 1, 0, level.width - 1);
+        int j0 = std::clamp(j, 0, level.height - 1), j1 = std::clamp(j + 1, 0, level.height - 1);
+        const glm::u8vec4* row0 = level.pixels.data() + j0 * level.width;
+        const glm::u8vec4* row1 = level.pixels.data() + j1 * level.width;
+        auto texel = [](const glm::u8vec4& t) { return Engine::Formats::RGBA8::Decode(t); };
+        return (texel(row0[i0]) * (1.0f - fu) + texel(row0[i1]) * fu) * (1.0f - fv) + (texel(row1[i0]) * (1.0f - fu) + texel(row1[i1]) * fu) * fv;
+    }
+
+    void SVGRasterizer::ShadeImageSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint) {
+        const Bitmap& bitmap = *paint.image;
+        // the transform is affine, so one mip level fits the whole span: texels per pixel, rounded down
+        float footprint = std::max(glm::length(glm::vec2(paint.inverse[0])), glm::length(glm::vec2(paint.inverse[1])));
+        int levelIndex = std::clamp((int)std::floor(std::log2(std::max(footprint, 1.0f))), 0, (int)bitmap.levels.size() - 1);
+        const Bitmap::Level& level = bitmap.levels[levelIndex];
+        glm::vec2 toLevel = { (float)level.width / bitmap.levels[0].width, (float)level.height / bitmap.levels[0].height };
+
+        glm::vec2 size = glm::vec2(bitmap.levels[0].width, bitmap.levels[0].height);
+        glm::vec2 p = glm::vec2(paint.inverse * glm::vec3(x0 + 0.5f, y + 0.5f, 1.0f));
+        glm::vec2 dp = glm::vec2(paint.inverse[0]);
+        for (int x = x0; x < x1; x++, p += dp) {
+            if (p.x < 0 or p.y < 0 or p.x >= size.x or p.y >= size.y) continue;
+            glm::vec4 c = SampleBilinear(level, p * toLevel, size * toLevel);
+            if (c.a < 1e-6f) continue;
+            SetPixel(image, x, y, glm::vec4(glm::vec3(c) / c.a, c.a * color.a));
+        }
+    }
+
+    void SVGRasterizer::ShadeSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint) {
+        if (color.a < 1e-6 or y < 0 or y >= image.GetSizeY()) return;
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, (int)image.GetSizeX());
+        if (x0 >= x1) return;
+        if (paint.image) {
+            ShadeImageSpan(image, y, x0, x1, color, paint);
+            return;
+        }
+        if (!paint.gradient) {
+            if (_surface >= 0) {
+                for (int x = x0; x < x1; x++) SetPixel(image, x, y, color);
+                return;
+            }
+            // solid paint straight onto the image: one blend per texel of the row
+            glm::vec3 source = glm::vec3(color) * color.a;
+            auto row = image.Row(y);
+            for (int x = x0; x < x1; x++) row[x] = Engine::Formats::RGB8::Encode(source + Engine::Formats::RGB8::Decode(row[x]) * (1.0f - color.a));
+            return;
+        }
+
+        // gradient-space position of the first pixel center, and its step per pixel
+        const Gradient& gradient = *paint.gradient;
+        glm::vec2 g = glm::vec2(paint.inverse * glm::vec3(x0 + 0.5f, y + 0.5f, 1.0f));
+        glm::vec2 dg = glm::vec2(paint.inverse[0][0], paint.inverse[0][1]);
+        auto shade = [&](int x, float t) {
+            glm::vec4 c = SampleLut(gradient, t);
+            c.a *= color.a;
+            SetPixel(image, x, y, c);
+        };
+
+        if (gradient.type == GradientType::Linear) {
+            glm::vec2 d = gradient.p2 - gradient.p1;
+            float inv = glm::dot(d, d) > 1e-12f ? 1.0f / glm::dot(d, d) : 0.0f;
+            float t = glm::dot(g - gradient.p1, d) * inv;
+            float dt = glm::dot(dg, d) * inv;
+            for (int x = x0; x < x1; x++, t += dt) shade(x, t);
+            return;
+        }
+
+        // radial with focal point: t = A / (-B + sqrt(B^2 - A C)) where, for d = p - focus,
+        // A = |d|^2 and B = (focus - center).d are stepped by forward differences
+        glm::vec2 e = gradient.focus - gradient.center;
+        glm::vec2 d = g - gradient.focus;
+        float C = glm::dot(e, e) - gradient.radius * gradient.radius;
+        float A = glm::dot(d, d);
+        float dA = 2.0f * glm::dot(d, dg) + glm::dot(dg, dg);
+        float ddA = 2.0f * glm::dot(dg, dg);
+        float B = glm::dot(e, d);
+        float dB = glm::dot(e, dg);
+        for (int x = x0; x < x1; x++) {
+            float denom = -B + std::sqrt(std::max(B * B - A * C, 0.0f));
+            shade(x, denom > 1e-12f ? A / denom : 0.0f);
+            A += dA;
+            dA += ddA;
+            B += dB;
+        }
+    }
+
+    glm::vec4 SVGRasterizer::ReadPixel(Common::ImageRGB& image, int x, int y) {
+        if (_surface >= 0) {
+            const LayerState& target = _layers[_surface];
+            if (x < target.x or x >= target.x + target.width or y < target.y or y >= target.y + target.height) return glm::vec4(0.0f);
+            return target.pixels[(y - target.y) * target.width + x - target.x];
+        }
+        return glm::vec4(Engine::Formats::RGB8::Decode(image.Texel(x, y)), 1.0f);
+    }
+
+    void SVGRasterizer::WritePixel(Common::ImageRGB& image, int x, int y, const glm::vec4& color) {
+        if (_surface >= 0) {
+            LayerState& target = _layers[_surface];
+            if (x < target.x or x >= target.x + target.width or y < target.y or y >= target.y + target.height) return;
+            target.pixels[(y - target.y) * target.width + x - target.x] = color;
+            return;
+        }
+        image.Texel(x, y) = Engine::Formats::RGB8::Encode(glm::vec3(color));
+    }
+
     void SVGRasterizer::SetPixel(Common::ImageRGB& image, int x, int y, const glm::vec4 color) {
+        if (_sample >= 0) {
+            if (color.a >= 1e-6) Cover(y, x, x + 1);
+            return;
+        }
+        if (_surface >= 0) {
+            glm::vec4 dst = ReadPixel(image, x, y);
+            WritePixel(image, x, y, glm::vec4(glm::vec3(color) * color.a, color.a) + dst * (1.0f - color.a));
+            return;
+        }
         if (x >= 0 && x < image.GetSizeX() && y >= 0 && y < image.GetSizeY()) { 
-            glm::vec3 bgColor = image.At(x, y);
-            image.At(x, y) = glm::vec3(color) * color.a + bgColor * (1.0f - color.a); 
+            auto& texel = image.Texel(x, y);
+            texel = Engine::Formats::RGB8::Encode(glm::vec3(color) * color.a + Engine::Formats::RGB8::Decode(texel) * (1.0f - color.a));
         }
     }
     
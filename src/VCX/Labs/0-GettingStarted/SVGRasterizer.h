@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <map>
+#include <tuple>
 #include <vector>
 #include "SVGData.h"
 #include "Labs/Common/ImageRGB.h"
@@ -12,17 +15,113 @@ namespace VCX::Labs::GettingStarted {
             Common::ImageRGB &       output,
             Common::ImageRGB const & input,
             int              rate);
-    
+        // coverage samples per pixel. 1 samples each pixel once; 2, 4, 8, 16 or 32 (other counts round up) scan
+        // convert every shape at that many n-rooks positions into per-pixel coverage bits, then blend it once per
+        // pixel by the share of bits set: multi-sample edges for one extra word per pixel instead of an n-times image
+        void SetSamples(int samples);
+        int  GetSamples() const { return _samples; }
+        // one sample per pixel at `offset` in [0, 1)^2 within it, for fills and strokes alike, through the coverage
+        // path: averaging passes at different offsets converges to supersampling. SetSamples drops it
+        void SetSampleOffset(glm::vec2 offset);
+        // with more than one sample, moves each pixel's samples together within their n-rooks cells by the bundled
+        // blue-noise tile: fine repeated patterns then alias into high-frequency noise instead of moire.
+        // `origin` is the target's top-left pixel within the whole frame, so regions drawn apart read one pattern
+        void SetJitter(bool jitter, glm::ivec2 origin = glm::ivec2(0));
+        bool GetJitter() const { return _noise != nullptr; }
+        glm::ivec2 GetJitterOrigin() const { return _noiseOrigin; }
+
+        static constexpr int NoiseTile = 256;
+
     private:
         void DrawRect(Common::ImageRGB& image, Rect* rect);
         void DrawCircle(Common::ImageRGB& image, Circle* circle);
         void DrawEllipse(Common::ImageRGB& image, Ellipse* ellipse);
-        void DrawLine(Common::ImageRGB& image, const glm::vec2& p0, const glm::vec2& p1, float width, glm::vec4 color, StrokeLinecap linecap);
-        void DrawTriangle(Common::ImageRGB& image, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 color);
+        void DrawLine(Common::ImageRGB& image, const glm::vec2& p0, const glm::vec2& p1, float width, glm::vec4 color, const Paint& paint, StrokeLinecap linecap);
+        void DrawTriangle(Common::ImageRGB& image, glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 color, const Paint& paint);
         void HandleLineJoin(Common::ImageRGB& image, glm::vec2 p_prev, glm::vec2 p_curr, glm::vec2 p_next, Path* path);
         void StrokePath(Common::ImageRGB& image, Path* path);
         void DrawPath(Common::ImageRGB& image, Path* path);
+        void DrawUse(Common::ImageRGB& image, Use* use);
+        void DrawSampled(Common::ImageRGB& image, Shape* shape);
+        void Cover(int y, int x0, int x1);
+        // while sampling, how far the samples of pixel (x, y) are moved from their cell centers: at most half a cell
+        glm::vec2 Jitter(int x, int y) const;
+        void ResolveCoverage(Common::ImageRGB& image, const glm::vec4& color, const Paint& paint);
+        void BeginLayer(Common::ImageRGB& image, const std::vector<Shape*>& shapes, int index);
+        void EndLayer(Common::ImageRGB& image);
+        glm::vec4 GetBounds(Shape* shape);
         
         void SetPixel(Common::ImageRGB& image, int x, int y, const glm::vec4 color);
+        // premultiplied access to the current target: the canvas, or the innermost filter surface
+        glm::vec4 ReadPixel(Common::ImageRGB& image, int x, int y);
+        void WritePixel(Common::ImageRGB& image, int x, int y, const glm::vec4& color);
+        // blends pixels [x0, x1) of row y inside the current clip; gradients are shaded from their LUT along the span
+        void FillSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint);
+        void ShadeSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint);
+        void ShadeImageSpan(Common::ImageRGB& image, int y, int x0, int x1, const glm::vec4& color, const Paint& paint);
+
+        // clip region as sorted, disjoint [x0, x1) runs; row y owns spans[rows[y - y0]] .. spans[rows[y - y0 + 1]]
+        struct ClipMask {
+            int y0 = 0, y1 = 0;
+            std::vector<int> rows;
+            std::vector<std::pair<int, int>> spans;
+        };
+
+        // `sample` >= 0 gives the mask as seen by that sample position rather than by the pixel corner
+        const ClipMask& GetClipMask(const ClipPath* clip, int width, int height, int sample = -1);
+
+        // coverage of one definition entry, shared by instances whose transforms differ only by translation
+        struct CoverageMask {
+            int x, y, width, height;
+            std::vector<unsigned char> fill, stroke;
+        };
+        using MaskKey = std::tuple<const Definition*, int, float, float, float, float, float, int, int, int, int, std::vector<float>, float>;
+
+        Path StyleInstance(Use* use, int entry);
+        MaskKey GetMaskKey(Use* use, int entry, const Path& instance);
+        const CoverageMask& GetMask(const MaskKey& key, Use* use, int entry, const Path& instance);
+        void BlitMask(Common::ImageRGB& image, const CoverageMask& mask, const std::vector<unsigned char>& coverage, int x, int y, glm::vec4 color, const Paint& paint);
+
+        std::map<MaskKey, CoverageMask> _masks;
+        std::map<MaskKey, int>          _maskUses;
+
+        // anti-aliased coverage of one glyph at one size and quarter-pixel x offset, kept across Rasterize calls;
+        // (x, y) is its top-left relative to the pixel the pen is snapped to
+        struct GlyphMask {
+            int x, y, width, height;
+            std::vector<unsigned char> coverage;
+        };
+        using GlyphKey = std::tuple<const SVGFont*, int, int, int>;   // font, glyph, pixels per em in 1/16, x offset in 1/4
+
+        // false when the glyph is stroked, turned or too large, and has to be drawn as a path
+        bool DrawGlyph(Common::ImageRGB& image, Use* use, const Path& instance);
+        const GlyphMask& GetGlyph(const GlyphKey& key);
+
+        std::map<GlyphKey, GlyphMask> _glyphs;
+        std::size_t                   _glyphBytes = 0;
+
+        std::map<std::pair<const ClipPath*, int>, ClipMask> _clipMasks;
+        const ClipMask*                                     _clip = nullptr;
+
+        int                    _samples = 1;
+        std::vector<glm::vec2> _sampleOffsets;            // per sample, its position within the pixel
+        int                    _sample = -1;              // sample spans currently mark instead of shading, or -1
+        const float*           _noise = nullptr;          // the blue-noise tile while jittering
+        glm::ivec2             _noiseOrigin = glm::ivec2(0);
+        std::vector<uint32_t>  _coverage;                 // per target pixel, bit i set when sample i is covered
+        int                    _coverageWidth = 0;
+        glm::ivec4             _covered = glm::ivec4(0);  // x0, y0, x1, y1 of the pixels with bits set
+
+        // an open layer, restricted to its device-space bounds: the saved backdrop, or for a filtered
+        // layer the premultiplied RGBA surface its children are drawn into
+        struct LayerState {
+            int x, y, width, height;
+            float opacity;
+            std::shared_ptr<const Filter> filter;
+            std::vector<glm::vec4> pixels;
+        };
+        std::vector<LayerState>              _layers;
+        std::vector<std::vector<glm::vec4>>  _layerPool;
+        int                                  _surface = -1;   // index of the innermost filtered layer
     };
 }
\ No newline at end of file
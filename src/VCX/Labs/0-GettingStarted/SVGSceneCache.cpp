@@ -0,0 +1,265 @@
+#include "SVGSceneCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "Engine/loader.h"
+#include "SVGImage.h"
+#include "SVGParser.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VCX::Labs::GettingStarted {
+
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t format;
+        std::uint32_t listVersion;
+        std::int32_t  detail;
+        std::uint64_t sourceHash;
+        std::uint64_t sourceSize;
+    };
+
+    static constexpr std::uint32_t CacheMagic = 0x43475653;   // "SVGC"
+
+    // read-only view of a whole file; empty when it cannot be opened
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+            _file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (_file == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(_file, &size) or size.QuadPart == 0) return;
+            _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!_mapping) return;
+            _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (_data) _size = (std::size_t)size.QuadPart;
+#else
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat info;
+            if (fstat(fd, &info) == 0 and info.st_size > 0) {
+                void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    _data = data;
+                    _size = (std::size_t)info.st_size;
+                }
+            }
+            close(fd);
+#endif
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (_data) UnmapViewOfFile(_data);
+            if (_mapping) CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+#else
+            if (_data) munmap(_data, _size);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::span<const std::byte> Bytes() const { return { static_cast<const std::byte*>(_data), _size }; }
+
+    private:
+        void*       _data = nullptr;
+        std::size_t _size = 0;
+#ifdef _WIN32
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#endif
+    };
+
+    // FNV-1a, continuing from `hash`
+    static std::uint64_t HashBytes(std::span<const std::byte> bytes, std::uint64_t hash = 1469598103934665603ull) {
+        for (std::byte b : bytes) {
+            hash ^= std::uint64_t(b);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // bounds-checked reads from a mapped entry; the first failure sticks and later reads return zeros
+    struct EntryReader {
+        std::span<const std::byte> bytes;
+        std::size_t                pos = 0;
+        bool                       ok = true;
+
+        template <typename T>
+        T Get() {
+            T value{};
+            if (!ok or bytes.size() - pos < sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, bytes.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string GetString() {
+            auto length = Get<std::uint32_t>();
+            if (!ok or bytes.size() - pos < length) {
+                ok = false;
+                return {};
+            }
+            std::string value(reinterpret_cast<const char*>(bytes.data() + pos), length);
+            pos += length;
+            return value;
+        }
+    };
+
+    // an external file the recording read, as it was when the entry was written
+    struct Dependency {
+        std::string   path;
+        std::uint64_t size = 0;
+        std::int64_t  modified = 0;
+    };
+
+    static Dependency Stat(const std::string& path) {
+        std::error_code error;
+        Dependency dependency { path };
+        dependency.size = std::filesystem::file_size(path, error);
+        if (error) dependency.size = ~std::uint64_t(0);
+        auto time = std::filesystem::last_write_time(path, error);
+        if (!error) dependency.modified = (std::int64_t)time.time_since_epoch().count();
+        return dependency;
+    }
+
+    // the files linked by <image> elements, which the recording decodes into the list
+    static void CollectDependencies(tinyxml2::XMLElement* elem, const std::string& directory, std::vector<Dependency>& dependencies) {
+        for (; elem; elem = elem->NextSiblingElement()) {
+            const char* href = std::string(elem->Name()) == "image" ? elem->Attribute("href") : nullptr;
+            if (!href and std::string(elem->Name()) == "image") href = elem->Attribute("xlink:href");
+            if (href) {
+                std::string path = SVGImage::ResolvePath(href, directory).string();
+                if (!path.empty() and std::none_of(dependencies.begin(), dependencies.end(), [&](const Dependency& d) { return d.path == path; }))
+                    dependencies.push_back(Stat(path));
+            }
+            CollectDependencies(elem->FirstChildElement(), directory, dependencies);
+        }
+    }
+
+    // written aside and renamed into place, so concurrent readers never map a partial entry
+    static void WriteEntry(const std::filesystem::path& entry, const SVGDisplayList& list, int detail, std::uint64_t hash, std::uint64_t sourceSize,
+                           const std::vector<Dependency>& dependencies) {
+        CacheHeader header { CacheMagic, SVGSceneCache::FormatVersion, SVGDisplayList::Version, detail, hash, sourceSize };
+        std::vector<std::byte> body = list.Serialize();
+        std::string listing;
+        auto put = [&](const void* p, std::size_t n) { listing.append(static_cast<const char*>(p), n); };
+        std::uint32_t count = (std::uint32_t)dependencies.size();
+        put(&count, sizeof(count));
+        for (auto& dependency : dependencies) {
+            std::uint32_t length = (std::uint32_t)dependency.path.size();
+            put(&length, sizeof(length));
+            put(dependency.path.data(), length);
+            put(&dependency.size, sizeof(dependency.size));
+            put(&dependency.modified, sizeof(dependency.modified));
+        }
+        std::filesystem::path temporary = entry;
+        temporary += ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(listing.data(), listing.size());
+            out.write(reinterpret_cast<const char*>(body.data()), body.size());
+            if (!out) {
+                std::cerr << "Warning: failed to write scene cache entry:" << entry.string() << std::endl;
+                out.close();
+                std::error_code ignored;
+                std::filesystem::remove(temporary, ignored);
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, entry, error);
+        if (error) {
+            std::cerr << "Warning: failed to write scene cache entry:" << entry.string() << std::endl;
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+    SVGSceneCache::SVGSceneCache(std::filesystem::path directory): _directory(std::move(directory)) {
+        std::error_code error;
+        std::filesystem::create_directories(_directory, error);
+        if (error) std::cerr << "Warning: cannot create scene cache directory:" << _directory.string() << std::endl;
+    }
+
+    SVGDisplayList SVGSceneCache::Load(const std::string& filename, int detail) {
+        return std::move(Load(filename, std::span<const int>(&detail, 1))[0]);
+    }
+
+    std::vector<SVGDisplayList> SVGSceneCache::Load(const std::string& filename, std::span<const int> details, tinyxml2::XMLDocument* doc) {
+        std::vector<int> clamped(details.size());
+        std::transform(details.begin(), details.end(), clamped.begin(), [](int detail) { return std::max(1, detail); });
+        tinyxml2::XMLDocument own;
+        if (!doc) doc = &own;
+        std::vector<SVGDisplayList> lists(clamped.size());
+        std::vector<std::byte> source = Engine::LoadBytes(filename);
+        if (source.empty()) {
+            if (doc == &own) SVGParser::LoadDocument(filename, own);
+            return SVGDisplayList::Record(*doc, filename, clamped);
+        }
+
+        // relative <image> links make the same bytes a different document in another directory
+        std::error_code absolute;
+        std::string directory = std::filesystem::absolute(filename, absolute).parent_path().string();
+        std::uint64_t hash = HashBytes(std::as_bytes(std::span(directory.data(), directory.size())), HashBytes(source));
+        std::vector<std::filesystem::path> entries(clamped.size());
+        std::vector<int> missing;
+        for (std::size_t k = 0; k < clamped.size(); k++) {
+            int detail = clamped[k];
+            char name[64];
+            std::snprintf(name, sizeof(name), "%016llx-%d.svgc", (unsigned long long)hash, detail);
+            entries[k] = _directory / name;
+
+            MappedFile file(entries[k]);
+            EntryReader reader { file.Bytes() };
+            CacheHeader header = reader.Get<CacheHeader>();
+            bool fresh = reader.ok and header.magic == CacheMagic and header.format == FormatVersion and header.listVersion == SVGDisplayList::Version
+                and header.detail == detail and header.sourceHash == hash and header.sourceSize == source.size();
+            auto count = fresh ? reader.Get<std::uint32_t>() : 0;
+            for (std::uint32_t i = 0; i < count and fresh; i++) {
+                Dependency written { reader.GetString(), reader.Get<std::uint64_t>(), reader.Get<std::int64_t>() };
+                Dependency current = Stat(written.path);
+                fresh = reader.ok and current.size == written.size and current.modified == written.modified;
+            }
+            if (!(fresh and reader.ok and SVGDisplayList::Deserialize(file.Bytes().subspan(reader.pos), lists[k]))) missing.push_back(int(k));
+        }
+        if (missing.empty()) return lists;
+
+        // every miss is recorded from one parse
+        if (doc == &own) SVGParser::LoadDocument(filename, own);
+        std::vector<Dependency> dependencies;
+        // relative to the directory the parser resolves against
+        CollectDependencies(doc->RootElement(), std::filesystem::path(filename).parent_path().string(), dependencies);
+        std::vector<int> missingDetails;
+        for (int k : missing) missingDetails.push_back(clamped[k]);
+        std::vector<SVGDisplayList> recorded = SVGDisplayList::Record(*doc, filename, missingDetails);
+        for (std::size_t m = 0; m < missing.size(); m++) {
+            SVGDisplayList& list = lists[missing[m]] = std::move(recorded[m]);
+            if (!list.Empty()) WriteEntry(entries[missing[m]], list, missingDetails[m], hash, source.size(), dependencies);
+        }
+        return lists;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+#include "SVGDisplayList.h"
+
+namespace VCX::Labs::GettingStarted {
+    // Recorded display lists persisted under `directory`, one file per (source bytes, source directory, detail).
+    // Entries are memory-mapped and decoded without touching the XML; a missing, foreign or outdated
+    // entry is re-recorded from the source and rewritten. Each entry lists the external <image> files
+    // the document links with their size and modification time, and goes stale when any of them changes.
+    class SVGSceneCache {
+    public:
+        static constexpr std::uint32_t FormatVersion = 2;
+
+        explicit SVGSceneCache(std::filesystem::path directory);
+
+        SVGDisplayList Load(const std::string& filename, int detail);
+        // one list per entry of `details`, in order; misses are recorded from `doc`, which holds `filename` already
+        // loaded (see SVGParser::LoadDocument), or from one parse of the file when it is null
+        std::vector<SVGDisplayList> Load(const std::string& filename, std::span<const int> details, tinyxml2::XMLDocument* doc = nullptr);
+
+    private:
+        std::filesystem::path _directory;
+    };
+}
@@ -0,0 +1,391 @@
+#include "SVGScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+#include "Engine/Parallel.hpp"
+
+namespace VCX::Labs::GettingStarted {
+    // model constants in nanoseconds on one core. These are hand-tuned estimates, not a fit: they only need to
+    // rank plans, and fill, resolve and the per-pass cost dominate that. `svg-cli bench-schedule` prints the
+    // predicted and measured time of each plan to re-tune them against
+    namespace Cost {
+        constexpr double Op        = 40;       // per op and pass: bounds test and dispatch
+        constexpr double Shape     = 5000;     // per visible op and pass: paint setup, clip lookup, retargeting
+        constexpr double Vertex    = 50;       // per outline point and pass: transform, trim, edge setup
+        constexpr double EdgeRow   = 2;        // per edge crossing a sample row: the scanline walk
+        constexpr double Fill      = 11.5;     // per covered sample: span shading and blending
+        constexpr double Clear     = 0.5;      // per frame sample: clear to white
+        constexpr double Resolve   = 5;        // per frame sample when supersampling
+        constexpr double Cover     = 1.5;      // per covered pixel and coverage sample: the span and its bit
+        constexpr double Jitter    = 0.5;      // per covered pixel and coverage sample: the blue-noise lookups
+        constexpr double Filter    = 20;       // per filtered sample and primitive
+        constexpr double Pass      = 100000;   // per frame, band or tile: buffers, rasterizer setup, copy-out
+        constexpr double Thread    = 60000;    // per extra thread: wake-up and the slowest-tile tail
+        constexpr double Imbalance = 1.15;     // tiles never split the work evenly
+    }
+
+    std::string SVGRenderPlan::Describe() const {
+        std::ostringstream text;
+        if (strategy == SVGStrategy::Serial) text << "serial";
+        else if (strategy == SVGStrategy::Banded) text << "serial, bands of " << regionSize << " rows";
+        else if (strategy == SVGStrategy::Tiled) text << regionSize << "px tiles on " << threads << (threads == 1 ? " thread" : " threads");
+        else text << "adaptive, " << regionSize << "px edge tiles on " << threads << (threads == 1 ? " thread" : " threads");
+        text << ", " << ssaa << "x SSAA";
+        if (samples > 1) text << ", " << samples << "x MSAA" << (jitter ? " jittered" : "");
+        text << ", predicted " << predictedMs << " ms";
+        if (strategy != SVGStrategy::Serial) text << " (serial " << serialMs << " ms)";
+        return text.str();
+    }
+
+    struct Outline {
+        std::size_t vertices = 0, edges = 0;
+        double      rise = 0;   // summed |dy| of all segments
+    };
+
+    static Outline Trace(const Path& path) {
+        Outline outline;
+        for (auto& subpath : path.sub_paths) {
+            outline.vertices += subpath.size();
+            outline.edges += subpath.size();
+            for (std::size_t i = 0; i < subpath.size(); i++)
+                outline.rise += std::abs(subpath[(i + 1) % subpath.size()].y - subpath[i].y);
+        }
+        return outline;
+    }
+
+    SVGComplexity SVGScheduler::Measure(const SVGDisplayList& list, float scale, int ssaa, int width, int height, int samples) {
+        SVGComplexity c;
+        c.width = width, c.height = height;
+        c.ssaa = std::max(1, ssaa);
+        c.samples = std::max(1, samples);
+        c.ops = list.GetShapes().size();
+        // recorded units -> output pixels
+        double k = scale / list.GetDetail();
+        glm::vec4 frame(0.0f, 0.0f, width / k, height / k);
+        auto clipped = [&](const glm::vec4& b) {
+            return glm::vec4(std::max(b.x, frame.x), std::max(b.y, frame.y), std::min(b.z, frame.z), std::min(b.w, frame.w));
+        };
+
+        std::map<const Definition*, Outline> definitions;
+        auto& shapes = list.GetShapes();
+        auto& bounds = list.GetBounds();
+        for (std::size_t i = 0; i < shapes.size(); i++) {
+            const Shape* shape = shapes[i];
+            if (shape->type == ShapeType::LayerBegin) {
+                auto& filter = static_cast<const Layer*>(shape)->filter;
+                glm::vec4 region = filter ? clipped(filter->region) : glm::vec4(0.0f);
+                if (region.z > region.x and region.w > region.y)
+                    c.filteredArea += (region.z - region.x) * (region.w - region.y) * k * k * filter->primitives.size();
+                continue;
+            }
+            if (shape->type == ShapeType::LayerEnd) continue;
+            glm::vec4 b = clipped(bounds[i]);
+            if (b.z <= b.x or b.w <= b.y) continue;
+            double w = (b.z - b.x) * k, h = (b.w - b.y) * k;
+            c.shapes++;
+            c.coveredArea += w * h;
+            c.extentX += w;
+            c.extentY += h;
+
+            Outline outline;
+            double linear = 1;
+            bool stroked = shape->strokeColor.a > 1e-6 and shape->strokeWidth > 0;
+            if (shape->type == ShapeType::Path) outline = Trace(*static_cast<const Path*>(shape));
+            else if (shape->type == ShapeType::Use) {
+                auto use = static_cast<const Use*>(shape);
+                auto [it, inserted] = definitions.try_emplace(use->definition.get());
+                if (inserted)
+                    for (auto& entry : use->definition->entries) {
+                        Outline part = Trace(*entry.path);
+                        it->second.vertices += part.vertices;
+                        it->second.edges += part.edges;
+                        it->second.rise += part.rise;
+                    }
+                outline = it->second;
+                const glm::mat3& T = use->transform;
+                linear = std::sqrt(std::abs(T[0][0] * T[1][1] - T[1][0] * T[0][1]));
+                stroked = use->style.stroke.a > 1e-6 and use->style.strokeWidth > 0;
+            } else outline = { 4, 4, 2.0 * (bounds[i].w - bounds[i].y) };
+            // a stroke adds a quad per segment, each side crossing about the rows the segment does
+            if (stroked) {
+                outline.edges *= 5;
+                outline.rise *= 3;
+            }
+            c.vertices += outline.vertices;
+            c.edges += outline.edges;
+            c.edgeRows += outline.rise * linear * k * c.ssaa + outline.edges;
+        }
+        double area = double(width) * height;
+        c.overdraw = area > 0 ? c.coveredArea / area : 0;
+        if (c.ssaa > 1) {
+            std::vector<bool> edges = EdgeTiles(list, scale, width, height);
+            int columns = (width + EdgeTile - 1) / EdgeTile;
+            for (std::size_t i = 0; i < edges.size(); i++) {
+                if (!edges[i]) continue;
+                int x = int(i % columns) * EdgeTile, y = int(i / columns) * EdgeTile;
+                c.edgeArea += double(std::min(EdgeTile, width - x)) * std::min(EdgeTile, height - y);
+                if (i % columns == 0 or !edges[i - 1]) c.edgeRuns++;
+            }
+        }
+        return c;
+    }
+
+    std::vector<bool> SVGScheduler::EdgeTiles(const SVGDisplayList& list, float scale, int width, int height, int tile) {
+        tile = std::max(1, tile);
+        int columns = (width + tile - 1) / tile, rows = (height + tile - 1) / tile;
+        std::vector<bool> edges(std::size_t(columns) * rows, false);
+        float k = scale / list.GetDetail();
+        auto cell = [&](float v, int count) { return int(std::floor(std::clamp(v / tile, -1.0f, float(count)))); };
+        // marks the tiles an output-pixel box touches
+        auto mark = [&](glm::vec2 lo, glm::vec2 hi) {
+            int x0 = std::max(0, cell(lo.x, columns)), x1 = std::min(columns - 1, cell(hi.x, columns));
+            int y0 = std::max(0, cell(lo.y, rows)), y1 = std::min(rows - 1, cell(hi.y, rows));
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++) edges[std::size_t(y) * columns + x] = true;
+        };
+        auto box = [&](const glm::vec4& b) { mark(glm::vec2(b.x, b.y) * k, glm::vec2(b.z, b.w) * k); };
+        // marks every tile within `pad` output pixels of the closed outline, a tile-long piece of segment at a time
+        auto outline = [&](const Path& path, const glm::mat3& T, float pad) {
+            for (auto& subpath : path.sub_paths)
+                for (std::size_t i = 0; i < subpath.size(); i++) {
+                    glm::vec2 a = glm::vec2(T * glm::vec3(subpath[i], 1.0f)) * k;
+                    glm::vec2 b = glm::vec2(T * glm::vec3(subpath[(i + 1) % subpath.size()], 1.0f)) * k;
+                    glm::vec2 lo = glm::min(a, b) - pad, hi = glm::max(a, b) + pad;
+                    if (hi.x < 0 or hi.y < 0 or lo.x > width or lo.y > height) continue;
+                    // pieces of far-reaching segments may span several tiles, which only marks more
+                    int pieces = int(std::clamp(std::ceil(glm::length(b - a) / tile), 1.0f, 2.0f * (columns + rows)));
+                    for (int j = 0; j < pieces; j++) {
+                        glm::vec2 p = a + (b - a) * (float(j) / pieces), q = a + (b - a) * (float(j + 1) / pieces);
+                        mark(glm::min(p, q) - pad, glm::max(p, q) + pad);
+                    }
+                }
+        };
+        // mip and LUT lookups only agree with the supersampled average when the paint is smooth over a pixel
+        auto rough = [](const Paint& paint) {
+            return paint.image or (paint.gradient and paint.gradient->spread != SpreadMethod::Pad);
+        };
+
+        std::set<const ClipPath*> clips;
+        auto& shapes = list.GetShapes();
+        auto& bounds = list.GetBounds();
+        glm::mat3 identity(1.0f);
+        for (std::size_t i = 0; i < shapes.size(); i++) {
+            const Shape* shape = shapes[i];
+            if (shape->type == ShapeType::LayerBegin) {
+                // filters move and spread content, so their whole region is resampled
+                if (auto& filter = static_cast<const Layer*>(shape)->filter) box(filter->region);
+                continue;
+            }
+            if (shape->type == ShapeType::LayerEnd) continue;
+            const glm::vec4& b = bounds[i];
+            if (b.z * k < 0 or b.w * k < 0 or b.x * k > width or b.y * k > height) continue;
+            for (const ClipPath* clip = shape->clip.get(); clip and clips.insert(clip).second; clip = clip->parent.get())
+                for (auto path : clip->paths) outline(*path, identity, 1.0f);
+
+            if (shape->type == ShapeType::Path) {
+                auto path = static_cast<const Path*>(shape);
+                bool stroked = path->strokeColor.a > 1e-6 and path->strokeWidth > 1e-6;
+                if ((path->fillColor.a >= 1e-6 and rough(path->fillPaint)) or (stroked and rough(path->strokePaint))) box(b);
+                else if (path->fillColor.a >= 1e-6 or stroked)
+                    // miter joins reach up to 4 half-widths past the outline; the 1x pass is off by at most a pixel
+                    outline(*path, identity, (stroked ? path->strokeWidth * 2.0f * k : 0.0f) + 1.0f);
+            } else if (shape->type == ShapeType::Use) {
+                auto use = static_cast<const Use*>(shape);
+                const glm::mat3& T = use->transform;
+                float linear = std::sqrt(std::abs(T[0][0] * T[1][1] - T[1][0] * T[0][1]));
+                auto& entries = use->definition->entries;
+                for (std::size_t e = 0; e < entries.size(); e++) {
+                    RenderStyle style = InheritStyle(use->style, entries[e].style);
+                    float strokeWidth = style.strokeWidth * std::sqrt(std::abs(glm::determinant(entries[e].transform))) * linear;
+                    bool stroked = style.stroke.a * style.totalOpacity > 1e-6 and strokeWidth > 1e-6;
+                    bool paint = (!use->fillPaints.empty() and rough(use->fillPaints[e])) or (!use->strokePaints.empty() and rough(use->strokePaints[e]));
+                    if (paint) box(b);
+                    else outline(*entries[e].path, T, (stroked ? strokeWidth * 2.0f * k : 0.0f) + 1.0f);
+                }
+            } else box(b);
+        }
+        return edges;
+    }
+
+    double SVGScheduler::Predict(const SVGComplexity& c, const SVGRenderPlan& plan) {
+        double ss = double(plan.ssaa) * plan.ssaa;
+        double samples = double(c.width) * c.height * ss;
+        // multi-sampling scan converts every shape once per sample, then shades it once
+        double passes = std::max(1, plan.samples);
+        double work = Cost::Pass + c.ops * Cost::Op
+                    + passes * (c.shapes * Cost::Shape + c.vertices * Cost::Vertex + c.edgeRows * Cost::EdgeRow)
+                    + c.coveredArea * ss * (Cost::Fill + (passes > 1 ? passes * (Cost::Cover + (plan.jitter ? Cost::Jitter : 0.0)) : 0.0)) + c.filteredArea * ss * Cost::Filter
+                    + samples * (Cost::Clear + (plan.ssaa > 1 ? Cost::Resolve : 0.0));
+        if (plan.strategy == SVGStrategy::Adaptive) {
+            // a plain 1x pass, then the edge runs as regions holding that share of the frame's fill;
+            // each op is trimmed about once per row of edge tiles it spans
+            double share = samples > 0 ? c.edgeArea * ss / samples : 0;
+            double rh = plan.regionSize;
+            double visits = c.edgeRuns > 0 ? c.shapes + c.extentY / rh : 0;
+            double perVisit = Cost::Shape + (c.shapes > 0 ? double(c.vertices) / c.shapes : 0.0) * Cost::Vertex + 2 * rh * plan.ssaa * Cost::EdgeRow;
+            work = Predict(c, { .ssaa = 1, .samples = plan.samples, .jitter = plan.jitter }) * 1e6
+                 + share * (c.coveredArea * ss * Cost::Fill + c.filteredArea * ss * Cost::Filter + samples * (Cost::Clear + Cost::Resolve))
+                 + c.edgeRuns * (Cost::Pass + c.ops * Cost::Op) + visits * perVisit;
+            if (plan.threads > 1 and c.edgeRuns > 1)
+                work = work * Cost::Imbalance / std::min<double>(plan.threads, c.edgeRuns) + (plan.threads - 1) * Cost::Thread;
+        } else if (plan.strategy != SVGStrategy::Serial) {
+            // every region culls all ops and re-trims each op it overlaps; trimmed outlines gain border edges
+            double rw = plan.strategy == SVGStrategy::Tiled ? plan.regionSize : c.width;
+            double rh = plan.regionSize;
+            double regions = std::ceil(c.width / rw) * std::ceil(c.height / rh);
+            double visits = c.coveredArea / (rw * rh) + c.extentX / rw + c.extentY / rh + c.shapes;
+            double perVisit = Cost::Shape + (c.shapes > 0 ? double(c.vertices) / c.shapes : 0.0) * Cost::Vertex + 2 * rh * plan.ssaa * Cost::EdgeRow;
+            work += (regions - 1) * (Cost::Pass + c.ops * Cost::Op) + std::max(0.0, visits - c.shapes) * perVisit;
+            if (plan.threads > 1)
+                work = work * Cost::Imbalance / std::min<double>(plan.threads, regions) + (plan.threads - 1) * Cost::Thread;
+        }
+        return work * 1e-6;
+    }
+
+    SVGRenderPlan SVGScheduler::Plan(const SVGComplexity& c, int threads, bool adaptive) {
+        // the executor keeps a worker even on one core, so the core count bounds useful parallelism
+        if (threads <= 0)
+            threads = std::min<int>(Engine::Executor::Instance().Size() + 1, std::max(1u, std::thread::hardware_concurrency()));
+        SVGRenderPlan best;
+        best.ssaa = c.ssaa;
+        best.samples = c.samples;
+        double sampleBytes = double(c.width) * c.ssaa * c.ssaa * 3;
+        // a full supersampled frame past the budget goes in bands even when that is slower
+        if (sampleBytes * c.height > BandBytes) {
+            best.strategy = SVGStrategy::Banded;
+            best.regionSize = std::max(1, int(BandBytes / sampleBytes));
+        }
+        best.serialMs = Predict(c, { .ssaa = c.ssaa, .samples = c.samples });
+        best.predictedMs = Predict(c, best);
+
+        for (int size : { 64, 128, 256, 512, 1024 }) {
+            if (size > 2 * std::max(c.width, c.height)) break;
+            int tiles = ((c.width + size - 1) / size) * ((c.height + size - 1) / size);
+            for (int n = 1; n <= std::min(threads, tiles); n++) {
+                SVGRenderPlan plan { .strategy = SVGStrategy::Tiled, .regionSize = size, .threads = n, .ssaa = c.ssaa, .samples = c.samples };
+                plan.predictedMs = Predict(c, plan);
+                if (plan.predictedMs < best.predictedMs) {
+                    plan.serialMs = best.serialMs;
+                    best = plan;
+                }
+            }
+        }
+        for (int n = 1; adaptive and c.ssaa > 1 and n <= std::min<int>(threads, std::max<std::size_t>(c.edgeRuns, 1)); n++) {
+            SVGRenderPlan plan { .strategy = SVGStrategy::Adaptive, .regionSize = EdgeTile, .threads = n, .ssaa = c.ssaa, .samples = c.samples };
+            plan.predictedMs = Predict(c, plan);
+            if (plan.predictedMs < best.predictedMs) {
+                plan.serialMs = best.serialMs;
+                best = plan;
+            }
+        }
+        return best;
+    }
+
+    // draws output pixels [x, x + w) x [y, y + h) at `ssaa` and copies them into the frame
+    static std::size_t DrawRegion(const SVGDisplayList& list, SVGRasterizer& target, Common::ImageRGB& image, float scale, int ssaa, const SVGRenderPlan& plan,
+                                  int x, int y, int w, int h) {
+        target.SetSamples(plan.samples);
+        target.SetJitter(plan.jitter, glm::ivec2(x, y) * ssaa);
+        Common::ImageRGB big = Common::ImageRGB::Uninitialized({ std::size_t(w * ssaa), std::size_t(h * ssaa) }, true);
+        std::size_t drawn = list.Replay(target, big, scale * ssaa, glm::vec2(x, y) / scale);
+        Common::ImageRGB small;
+        if (ssaa > 1) {
+            small = Common::ImageRGB::Uninitialized({ std::size_t(w), std::size_t(h) });
+            target.Supersample(small, big, ssaa);
+        }
+        const Common::ImageRGB& result = ssaa > 1 ? small : big;
+        for (int j = 0; j < h; j++) std::copy_n(result.Row(j), w, image.Row(y + j) + x);
+        return drawn;
+    }
+
+    std::size_t SVGScheduler::Render(const SVGDisplayList& list, SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, const SVGRenderPlan& plan) {
+        int width = image.GetSizeX(), height = image.GetSizeY();
+        int ssaa = std::max(1, plan.ssaa);
+        auto region = [&](SVGRasterizer& target, int x, int y, int w, int h) {
+            return DrawRegion(list, target, image, scale, ssaa, plan, x, y, w, h);
+        };
+
+        rasterizer.SetSamples(plan.samples);
+        rasterizer.SetJitter(plan.jitter);
+        if (plan.strategy == SVGStrategy::Serial) {
+            if (ssaa == 1) return list.Replay(rasterizer, image, scale);
+            Common::ImageRGB big = Common::ImageRGB::Uninitialized({ std::size_t(width * ssaa), std::size_t(height * ssaa) }, true);
+            std::size_t drawn = list.Replay(rasterizer, big, scale * ssaa);
+            rasterizer.Supersample(image, big, ssaa);
+            return drawn;
+        }
+        if (plan.strategy == SVGStrategy::Banded) {
+            int rows = std::max(1, plan.regionSize);
+            std::size_t drawn = 0;
+            for (int y = 0; y < height; y += rows) drawn += region(rasterizer, 0, y, width, std::min(rows, height - y));
+            return drawn;
+        }
+
+        int size = std::max(1, plan.regionSize);
+        int columns = (width + size - 1) / size, rows = (height + size - 1) / size;
+        std::atomic_size_t drawn = 0;
+        std::vector<glm::ivec4> regions;   // x, y, w, h
+        if (plan.strategy == SVGStrategy::Adaptive) {
+            drawn = list.Replay(rasterizer, image, scale);
+            if (ssaa == 1) return drawn;
+            // consecutive edge tiles in a row go as one region, so ops are trimmed once per run
+            std::vector<bool> edges = EdgeTiles(list, scale, width, height, size);
+            for (int y = 0; y < rows; y++)
+                for (int x = 0; x < columns; x++) {
+                    if (!edges[std::size_t(y) * columns + x]) continue;
+                    int end = x;
+                    while (end + 1 < columns and edges[std::size_t(y) * columns + end + 1]) end++;
+                    regions.push_back({ x * size, y * size, std::min((end + 1) * size, width) - x * size, std::min(size, height - y * size) });
+                    x = end;
+                }
+        } else {
+            for (int y = 0; y < rows; y++)
+                for (int x = 0; x < columns; x++)
+                    regions.push_back({ x * size, y * size, std::min(size, width - x * size), std::min(size, height - y * size) });
+        }
+
+        int count = int(regions.size());
+        std::atomic_int next = 0;
+        // one task per thread, each taking regions in order until none are left
+        Engine::ParallelFor(0, std::clamp(plan.threads, 1, std::max(count, 1)), [&](int) {
+            thread_local SVGRasterizer local;
+            for (int i; (i = next++) < count;) drawn += region(local, regions[i].x, regions[i].y, regions[i].z, regions[i].w);
+        });
+        return drawn;
+    }
+
+    std::size_t SVGScheduler::Repaint(const SVGDisplayList& list, SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, const SVGRenderPlan& plan, glm::ivec4 rect) {
+        int width = image.GetSizeX(), height = image.GetSizeY();
+        int x0 = std::max(0, rect.x), y0 = std::max(0, rect.y), x1 = std::min(width, rect.x + rect.z), y1 = std::min(height, rect.y + rect.w);
+        if (x0 >= x1 or y0 >= y1) return 0;
+        int ssaa = std::max(1, plan.ssaa);
+        int size = std::max(1, plan.regionSize);
+        std::size_t drawn = 0;
+        if (plan.strategy == SVGStrategy::Tiled) {
+            // whole tiles, drawn from the same origins as before
+            for (int ty = y0 / size; ty * size < y1; ty++)
+                for (int tx = x0 / size; tx * size < x1; tx++)
+                    drawn += DrawRegion(list, rasterizer, image, scale, ssaa, plan, tx * size, ty * size,
+                                        std::min(size, width - tx * size), std::min(size, height - ty * size));
+            return drawn;
+        }
+        if (plan.strategy != SVGStrategy::Adaptive or ssaa == 1)
+            return DrawRegion(list, rasterizer, image, scale, ssaa, plan, x0, y0, x1 - x0, y1 - y0);
+        // as Render does: 1x throughout, then the edge tiles of the whole frame's grid again at full rate
+        drawn = DrawRegion(list, rasterizer, image, scale, 1, plan, x0, y0, x1 - x0, y1 - y0);
+        int columns = (width + size - 1) / size;
+        std::vector<bool> edges = EdgeTiles(list, scale, width, height, size);
+        for (int ty = y0 / size; ty * size < y1; ty++)
+            for (int tx = x0 / size; tx * size < x1; tx++) {
+                if (!edges[std::size_t(ty) * columns + tx]) continue;
+                int ex0 = std::max(x0, tx * size), ey0 = std::max(y0, ty * size);
+                int ex1 = std::min({ x1, (tx + 1) * size, width }), ey1 = std::min({ y1, (ty + 1) * size, height });
+                drawn += DrawRegion(list, rasterizer, image, scale, ssaa, plan, ex0, ey0, ex1 - ex0, ey1 - ey0);
+            }
+        return drawn;
+    }
+}
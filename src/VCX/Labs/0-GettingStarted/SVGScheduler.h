@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "SVGDisplayList.h"
+#include "SVGRasterizer.h"
+#include "Labs/Common/ImageRGB.h"
+
+namespace VCX::Labs::GettingStarted {
+    // what one render of a recorded list will cost, gathered from the ops and their bounds without rasterizing.
+    // Areas are in output pixels; ops entirely off the frame are not counted.
+    struct SVGComplexity {
+        int         width = 0, height = 0;   // output frame
+        int         ssaa = 1;
+        int         samples = 1;             // coverage samples per pixel, see SVGRasterizer::SetSamples
+        std::size_t ops = 0;                 // every op in the list, visible or not: the per-pass culling work
+        std::size_t shapes = 0;              // visible drawing ops, an instance counting once
+        std::size_t vertices = 0;            // outline points, instanced geometry counted per instance
+        std::size_t edges = 0;               // outline segments, strokes adding their quads
+        double      edgeRows = 0;            // sample rows crossed by all edges: the scan-conversion work
+        double      coveredArea = 0;         // op bounds clipped to the frame, summed
+        double      extentX = 0, extentY = 0;   // clipped bound widths and heights, summed
+        double      overdraw = 0;            // coveredArea over the frame area
+        double      filteredArea = 0;        // filter regions clipped to the frame, once per primitive
+        double      edgeArea = 0;            // pixels in tiles a boundary crosses, see SVGScheduler::EdgeTiles; 0 without SSAA
+        std::size_t edgeRuns = 0;            // horizontal runs those tiles merge into
+    };
+
+    enum class SVGStrategy {
+        Serial,   // the whole frame in one pass on the calling thread
+        Banded,   // serial, supersampled a band of rows at a time to bound memory
+        Tiled,    // square tiles, each drawn and supersampled on its own, spread over the executor
+        Adaptive, // the frame at 1x, then supersampled again only in the tiles geometry boundaries cross
+    };
+
+    struct SVGRenderPlan {
+        SVGStrategy strategy = SVGStrategy::Serial;
+        int         regionSize = 0;   // tile edge, band height or edge tile, in output pixels
+        int         threads = 1;
+        int         ssaa = 1;
+        int         samples = 1;
+        bool        jitter = false;   // blue-noise sample positions, see SVGRasterizer::SetJitter
+        double      predictedMs = 0;
+        double      serialMs = 0;     // predicted cost of a plain serial pass, for comparison
+
+        std::string Describe() const;
+    };
+
+    // picks how to render a document from its complexity, using a linear cost model whose constants are
+    // hand-tuned per-op and per-sample costs on one core; `svg-cli bench-schedule` compares it with measurements
+    class SVGScheduler {
+    public:
+        // `scale` maps canvas units to output pixels, as in SVGDisplayList::Replay
+        static SVGComplexity Measure(const SVGDisplayList& list, float scale, int ssaa, int width, int height, int samples = 1);
+        static double Predict(const SVGComplexity& complexity, const SVGRenderPlan& plan);
+        // the cheapest predicted plan using at most `threads` threads (0: the executor's workers plus the caller).
+        // `adaptive` also allows Adaptive plans, whose output differs from full SSAA by a few levels in gradients and images
+        static SVGRenderPlan Plan(const SVGComplexity& complexity, int threads = 0, bool adaptive = false);
+        // draws into `image`, already sized to the frame the plan was made for, leaving the rasterizers it used
+        // at the plan's sample count and jitter; returns the ops drawn
+        static std::size_t Render(const SVGDisplayList& list, SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, const SVGRenderPlan& plan);
+        // redraws the output pixels `rect` (x, y, w, h) of a frame `plan` rendered, with the same antialiasing,
+        // after an edit to `list`; returns the ops drawn
+        static std::size_t Repaint(const SVGDisplayList& list, SVGRasterizer& rasterizer, Common::ImageRGB& image, float scale, const SVGRenderPlan& plan, glm::ivec4 rect);
+        // per `tile`-pixel output tile, row-major: whether an outline, clip edge, image or filter reaches into it.
+        // Any other tile is a flat or smoothly shaded interior that one sample per pixel already gets right.
+        static std::vector<bool> EdgeTiles(const SVGDisplayList& list, float scale, int width, int height, int tile = EdgeTile);
+
+        static constexpr std::size_t BandBytes = std::size_t(64) << 20;   // supersampled bytes a serial pass may hold
+        static constexpr int         EdgeTile = 16;
+    };
+}
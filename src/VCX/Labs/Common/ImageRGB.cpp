@@ -4,22 +4,17 @@
 
 namespace VCX::Labs::Common {
     ImageRGB CreatePureImageRGB(std::size_t const width, std::size_t const height, glm::vec3 const & color) {
-        ImageRGB image(width, height);
-        image.Fill(color);
-        return image;
+        return ImageRGB::Filled({ width, height }, color);
     }
 
     ImageRGB CreateCheckboardImageRGB(std::size_t const width, std::size_t const height, std::size_t const delta) {
-        ImageRGB image(width, height);
-        for (std::size_t x = 0; x < width; ++x) {
-            for (std::size_t y = 0; y < height; ++y) {
-                std::size_t xx = x / delta;
-                std::size_t yy = y / delta;
-                if ((xx + yy) % 2 == 0)
-                    image.At(x, y) = { .8, .8, .8 };
-                else
-                    image.At(x, y) = { 1., 1., 1. };
-            }
+        auto image = ImageRGB::Uninitialized({ width, height });
+        auto const light = Engine::Formats::RGB8::Encode({ .8, .8, .8 });
+        auto const white = Engine::Formats::RGB8::Encode({ 1., 1., 1. });
+        for (std::size_t y = 0; y < height; ++y) {
+            auto row = image.Row(y);
+            for (std::size_t x = 0; x < width; ++x)
+                row[x] = (x / delta + y / delta) % 2 == 0 ? light : white;
         }
         return image;
     }
@@ -29,14 +24,18 @@ namespace VCX::Labs::Common {
             spdlog::error("VCX::Labs::Common::AlphaBlend(..): incompatible size.");
             std::exit(EXIT_FAILURE);
         }
-        Common::ImageRGB result(source.GetSize());
+        auto result = Common::ImageRGB::Uninitialized(source.GetSize());
         auto width  = source.GetSizeX();
         auto height = source.GetSizeY();
-        for (std::size_t x = 0; x < width; ++x)
-            for (std::size_t y = 0; y < height; ++y) {
-                auto const c = source.At(x, y);
-                result.At(x, y) = glm::vec3(c.r, c.g, c.b) * c.a + dest.At(x, y) * (1 - c.a); 
+        for (std::size_t y = 0; y < height; ++y) {
+            auto const src = source.Row(y);
+            auto const dst = dest.Row(y);
+            auto       out = result.Row(y);
+            for (std::size_t x = 0; x < width; ++x) {
+                auto const c = Engine::Formats::RGBA8::Decode(src[x]);
+                out[x] = Engine::Formats::RGB8::Encode(glm::vec3(c.r, c.g, c.b) * c.a + Engine::Formats::RGB8::Decode(dst[x]) * (1 - c.a));
             }
+        }
         return result;
     }
 }
@@ -17,6 +17,11 @@ add_requires("tinyobjloader")
 add_requires("yaml-cpp")
 add_requires("eigen")
 add_requires("tinyxml2")
+add_requires("zlib")
+
+if is_mode("release") then
+    add_defines("NDEBUG")
+end
 
 if is_plat("macosx") then
     add_defines("PLATFORM_MACOSX")
@@ -89,6 +94,17 @@ target("svg")
     set_kind("binary")
     add_deps("lab-common")
     add_packages("tinyxml2")
+    add_packages("zlib")
+    add_headerfiles("src/VCX/Labs/0-GettingStarted/*.h")
+    add_headerfiles("src/VCX/Labs/0-GettingStarted/*.hpp")
+    add_files      ("src/VCX/Labs/0-GettingStarted/*.cpp")
+
+target("svg-cli")
+    set_kind("binary")
+    add_deps("lab-common")
+    add_packages("tinyxml2")
+    add_packages("zlib")
     add_headerfiles("src/VCX/Labs/0-GettingStarted/*.h")
     add_headerfiles("src/VCX/Labs/0-GettingStarted/*.hpp")
-    add_files      ("src/VCX/Labs/0-GettingStarted/*.cpp")
\ No newline at end of file
+    add_files      ("src/VCX/Labs/0-GettingStarted/*.cpp|main.cpp|App.cpp|CaseSVG.cpp")
+    add_files      ("src/VCX/Labs/0-GettingStarted/Cli/*.cpp")
\ No newline at end of file